@@ -15,16 +15,13 @@ echo "Please speak clearly when recording starts."
 read -p "Press Enter to start recording..."
 ./echotwin record demo_voice.wav
 
-echo "Step 2: Extracting features..."
-./echotwin featurize demo_voice.wav
+echo "Step 2: Cloning voice (feature extraction + training)..."
+./echotwin clone demo_voice.wav demo_voice.vec
 
-echo "Step 3: Training voice model..."  
-./echotwin train mel_features.npy f0_features.npy demo_voice.vec
-
-echo "Step 4: Testing synthesis..."
+echo "Step 3: Testing synthesis..."
 ./echotwin say "Hello! This is my cloned voice speaking." demo_voice.vec
 
-echo "Step 5: Exporting sample..."
+echo "Step 4: Exporting sample..."
 ./echotwin --export demo_voice.vec "Welcome to EchoTwin voice cloning!" welcome.wav
 
 echo ""
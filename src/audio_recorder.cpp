@@ -1,10 +1,10 @@
 #include "audio_recorder.h"
+#include "feature_config.h"
 #include <portaudio.h>
 #include <sndfile.h>
 #include <iostream>
 #include <cstring>
 
-#define SAMPLE_RATE 16000
 #define FRAMES_PER_BUFFER 1024
 #define RECORDING_DURATION 30
 
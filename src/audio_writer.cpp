@@ -0,0 +1,266 @@
+#include "audio_writer.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <climits>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define fdopen _fdopen
+#endif
+
+#define STREAMING_CHUNK_SIZE 0xFFFFFFFFu
+
+static void putLe32(unsigned char* out, uint32_t value) {
+    out[0] = value & 0xff;
+    out[1] = (value >> 8) & 0xff;
+    out[2] = (value >> 16) & 0xff;
+    out[3] = (value >> 24) & 0xff;
+}
+
+static void putLe16(unsigned char* out, uint16_t value) {
+    out[0] = value & 0xff;
+    out[1] = (value >> 8) & 0xff;
+}
+
+static OutputFormat formatFromExtension(const std::string& target) {
+    size_t dot = target.rfind('.');
+    if (dot == std::string::npos) return OutputFormat::Wav;
+
+    std::string extension = target.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return char(std::tolower(c)); });
+
+    if (extension == "flac") return OutputFormat::Flac;
+    if (extension == "ogg" || extension == "oga") return OutputFormat::Ogg;
+    if (extension == "raw" || extension == "pcm") return OutputFormat::Raw;
+    return OutputFormat::Wav;
+}
+
+// Parses the N of an "fd:N" target; only plain non-negative decimal
+// numbers that fit an int are accepted.
+static bool parseDescriptor(const std::string& target, int& fd) {
+    const char* digits = target.c_str() + 3;
+    if (*digits < '0' || *digits > '9') return false;
+
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(digits, &end, 10);
+    if (errno == ERANGE || *end != '\0' || value > INT_MAX) return false;
+
+    fd = int(value);
+    return true;
+}
+
+AudioWriter::AudioWriter()
+    : stream(nullptr), ownsStream(false), seekable(false), format(OutputFormat::Wav),
+      sampleRate(0), startOffset(0), dataBytes(0), position(0), discarding(false),
+      encoder(nullptr) {}
+
+AudioWriter::~AudioWriter() {
+    close();
+}
+
+bool AudioWriter::parseFormat(const std::string& name, OutputFormat& format) {
+    if (name == "auto") {
+        format = OutputFormat::Auto;
+    } else if (name == "wav") {
+        format = OutputFormat::Wav;
+    } else if (name == "raw" || name == "pcm") {
+        format = OutputFormat::Raw;
+    } else if (name == "flac") {
+        format = OutputFormat::Flac;
+    } else if (name == "ogg") {
+        format = OutputFormat::Ogg;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool AudioWriter::isStreamTarget(const std::string& target) {
+    return target == "-" || target.rfind("fd:", 0) == 0;
+}
+
+bool AudioWriter::open(const std::string& target, OutputFormat requestedFormat, int rate) {
+    close();
+
+    format = requestedFormat;
+    if (format == OutputFormat::Auto) {
+        format = isStreamTarget(target) ? OutputFormat::Wav : formatFromExtension(target);
+    }
+    sampleRate = rate;
+    dataBytes = 0;
+    position = 0;
+    discarding = false;
+
+    if (target == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        stream = stdout;
+        ownsStream = false;
+    } else if (target.rfind("fd:", 0) == 0) {
+        int fd;
+        if (!parseDescriptor(target, fd)) {
+            std::cerr << "Invalid file descriptor in output target: " << target << std::endl;
+            return false;
+        }
+        stream = fdopen(fd, "wb");
+        ownsStream = true;
+    } else {
+        stream = fopen(target.c_str(), "wb");
+        ownsStream = true;
+    }
+
+    if (!stream) {
+        std::cerr << "Failed to open output: " << target << " (" << std::strerror(errno) << ")" << std::endl;
+        return false;
+    }
+
+    seekable = fseek(stream, 0, SEEK_CUR) == 0;
+    startOffset = seekable ? ftell(stream) : 0;
+
+    if (format == OutputFormat::Wav) {
+        return writeWavHeader(seekable ? 0 : STREAMING_CHUNK_SIZE);
+    }
+
+    if (format == OutputFormat::Flac || format == OutputFormat::Ogg) {
+        SF_INFO info = {};
+        info.samplerate = sampleRate;
+        info.channels = 1;
+        info.format = format == OutputFormat::Flac
+            ? SF_FORMAT_FLAC | SF_FORMAT_PCM_16
+            : SF_FORMAT_OGG | SF_FORMAT_VORBIS;
+
+        SF_VIRTUAL_IO io = { vioGetFilelen, vioSeek, vioRead, vioWrite, vioTell };
+        encoder = sf_open_virtual(&io, SFM_WRITE, &info, this);
+        if (!encoder) {
+            std::cerr << "Failed to create encoder: " << sf_strerror(nullptr) << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool AudioWriter::write(const float* audio, size_t count) {
+    if (!stream) return false;
+
+    bool ok;
+    if (encoder) {
+        ok = sf_writef_float(encoder, audio, count) == sf_count_t(count);
+    } else {
+        ok = writePcm16(audio, count);
+    }
+
+    // Push each block downstream immediately; readers on a pipe should not
+    // wait for stdio buffering.
+    return ok && fflush(stream) == 0;
+}
+
+bool AudioWriter::close() {
+    if (!stream) return true;
+
+    bool ok = true;
+    if (encoder) {
+        ok = sf_close(encoder) == 0;
+        encoder = nullptr;
+    } else if (format == OutputFormat::Wav && seekable) {
+        uint32_t size = uint32_t(std::min<uint64_t>(dataBytes, STREAMING_CHUNK_SIZE - 36));
+        ok = fseek(stream, startOffset, SEEK_SET) == 0 && writeWavHeader(size);
+    }
+
+    ok = fflush(stream) == 0 && ok;
+    if (ownsStream) {
+        ok = fclose(stream) == 0 && ok;
+    }
+    stream = nullptr;
+    return ok;
+}
+
+bool AudioWriter::writeWavHeader(uint32_t dataSize) {
+    unsigned char header[44];
+    uint32_t riffSize = dataSize == STREAMING_CHUNK_SIZE ? STREAMING_CHUNK_SIZE : dataSize + 36;
+
+    std::memcpy(header, "RIFF", 4);
+    putLe32(header + 4, riffSize);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    putLe32(header + 16, 16);
+    putLe16(header + 20, 1);
+    putLe16(header + 22, 1);
+    putLe32(header + 24, sampleRate);
+    putLe32(header + 28, sampleRate * 2);
+    putLe16(header + 32, 2);
+    putLe16(header + 34, 16);
+    std::memcpy(header + 36, "data", 4);
+    putLe32(header + 40, dataSize);
+
+    return fwrite(header, 1, sizeof(header), stream) == sizeof(header);
+}
+
+// Assumes a little-endian host, which covers every platform in CMakePresets.
+bool AudioWriter::writePcm16(const float* audio, size_t count) {
+    std::vector<int16_t> pcm(count);
+    for (size_t i = 0; i < count; ++i) {
+        float clamped = std::max(-1.0f, std::min(1.0f, audio[i]));
+        pcm[i] = int16_t(std::nearbyint(clamped * 32767.0f));
+    }
+
+    size_t written = fwrite(pcm.data(), sizeof(int16_t), count, stream);
+    dataBytes += written * sizeof(int16_t);
+    return written == count;
+}
+
+sf_count_t AudioWriter::vioGetFilelen(void* userData) {
+    return sf_count_t(static_cast<AudioWriter*>(userData)->dataBytes);
+}
+
+// On a non-seekable target only no-op seeks succeed, so encoders cannot go
+// back and patch header totals (e.g. FLAC STREAMINFO); streaming decoders
+// do not rely on them. libsndfile does not pass a failed seek on to libFLAC,
+// which then writes its patch bytes anyway, so writes are dropped from a
+// failed seek until the next successful one instead of landing at the end
+// of the stream.
+sf_count_t AudioWriter::vioSeek(sf_count_t offset, int whence, void* userData) {
+    AudioWriter* writer = static_cast<AudioWriter*>(userData);
+
+    sf_count_t target = offset;
+    if (whence == SEEK_CUR) target = writer->position + offset;
+    if (whence == SEEK_END) target = sf_count_t(writer->dataBytes) + offset;
+
+    if (target != writer->position &&
+        (!writer->seekable || fseek(writer->stream, writer->startOffset + long(target), SEEK_SET) != 0)) {
+        writer->discarding = true;
+        return -1;
+    }
+
+    writer->discarding = false;
+    writer->position = target;
+    return writer->position;
+}
+
+sf_count_t AudioWriter::vioRead(void*, sf_count_t, void*) {
+    return 0;
+}
+
+sf_count_t AudioWriter::vioWrite(const void* ptr, sf_count_t count, void* userData) {
+    AudioWriter* writer = static_cast<AudioWriter*>(userData);
+    if (writer->discarding) return count;
+
+    sf_count_t written = fwrite(ptr, 1, count, writer->stream);
+    writer->position += written;
+    writer->dataBytes = std::max<uint64_t>(writer->dataBytes, writer->position);
+    return written;
+}
+
+sf_count_t AudioWriter::vioTell(void* userData) {
+    return static_cast<AudioWriter*>(userData)->position;
+}
\ No newline at end of file
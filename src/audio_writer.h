@@ -0,0 +1,52 @@
+#pragma once
+#include <sndfile.h>
+#include <cstdio>
+#include <string>
+
+enum class OutputFormat {
+    Auto,
+    Wav,
+    Raw,
+    Flac,
+    Ogg
+};
+
+// Incremental audio encoder. The target is a file path, "-" for stdout or
+// "fd:N" for an already open descriptor. Blocks are encoded and flushed as
+// they are written, so output can be piped while synthesis is still running.
+// WAV and raw PCM16 are written directly; WAV on a non-seekable target uses
+// the streaming convention of 0xFFFFFFFF chunk sizes. FLAC and Ogg/Vorbis go
+// through libsndfile's virtual I/O on the same stream.
+class AudioWriter {
+public:
+    AudioWriter();
+    ~AudioWriter();
+
+    bool open(const std::string& target, OutputFormat format, int sampleRate);
+    bool write(const float* audio, size_t count);
+    bool close();
+
+    static bool parseFormat(const std::string& name, OutputFormat& format);
+    static bool isStreamTarget(const std::string& target);
+
+private:
+    bool writeWavHeader(uint32_t dataBytes);
+    bool writePcm16(const float* audio, size_t count);
+
+    static sf_count_t vioGetFilelen(void* userData);
+    static sf_count_t vioSeek(sf_count_t offset, int whence, void* userData);
+    static sf_count_t vioRead(void* ptr, sf_count_t count, void* userData);
+    static sf_count_t vioWrite(const void* ptr, sf_count_t count, void* userData);
+    static sf_count_t vioTell(void* userData);
+
+    FILE* stream;
+    bool ownsStream;
+    bool seekable;
+    OutputFormat format;
+    int sampleRate;
+    long startOffset;
+    uint64_t dataBytes;
+    sf_count_t position;
+    bool discarding;
+    SNDFILE* encoder;
+};
\ No newline at end of file
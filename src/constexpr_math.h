@@ -0,0 +1,73 @@
+#pragma once
+
+// Compile-time replacements for the <cmath> functions needed to build DSP
+// tables. std::cos/std::log are not constexpr in C++17, so these use range
+// reduction plus a short series, which is accurate to double precision over
+// the ranges the tables need.
+namespace cmath {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double LN2 = 0.69314718055994530942;
+constexpr double LN10 = 2.30258509299404568402;
+
+constexpr double cos(double x) {
+    while (x > PI) x -= 2.0 * PI;
+    while (x < -PI) x += 2.0 * PI;
+
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 24; ++n) {
+        term *= -x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double sin(double x) {
+    return cos(x - PI / 2.0);
+}
+
+constexpr double log(double x) {
+    if (x <= 0.0) return -1e300;
+
+    int exponent = 0;
+    while (x > 2.0) { x /= 2.0; ++exponent; }
+    while (x < 1.0) { x *= 2.0; --exponent; }
+
+    // ln(x) = 2 * atanh((x - 1) / (x + 1)), converges quickly for x in [1, 2]
+    double y = (x - 1.0) / (x + 1.0);
+    double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int n = 1; n < 60; n += 2) {
+        sum += term / n;
+        term *= y2;
+    }
+    return 2.0 * sum + exponent * LN2;
+}
+
+constexpr double exp(double x) {
+    int exponent = 0;
+    while (x > LN2) { x -= LN2; ++exponent; }
+    while (x < -LN2) { x += LN2; --exponent; }
+
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 30; ++n) {
+        term *= x / n;
+        sum += term;
+    }
+    while (exponent > 0) { sum *= 2.0; --exponent; }
+    while (exponent < 0) { sum /= 2.0; ++exponent; }
+    return sum;
+}
+
+constexpr double log10(double x) {
+    return log(x) / LN10;
+}
+
+constexpr double pow10(double x) {
+    return exp(x * LN10);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "cpu_dispatch.h"
+
+#if defined(ECHOTWIN_X86_KERNELS) && (defined(__x86_64__) || defined(_M_X64))
+#define CPU_DISPATCH_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef CPU_DISPATCH_X86
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, int(leaf), int(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = unsigned(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switch (XCR0).
+static uint64_t enabledStateMask() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (uint64_t(edx) << 32) | eax;
+#endif
+}
+#endif
+
+// A level counts as supported only if the CPU has every extension its
+// kernels are built with and the OS preserves the matching vector registers.
+IsaLevel CpuDispatch::detect() {
+#ifdef CPU_DISPATCH_X86
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+    if (maxLeaf < 7) return IsaLevel::Generic;
+
+    cpuid(1, 0, regs);
+    const bool fma = regs[2] & (1u << 12);
+    const bool osxsave = regs[2] & (1u << 27);
+    const bool avx = regs[2] & (1u << 28);
+    const bool f16c = regs[2] & (1u << 29);
+    if (!osxsave || !avx) return IsaLevel::Generic;
+
+    const uint64_t xcr0 = enabledStateMask();
+    if ((xcr0 & 0x6) != 0x6) return IsaLevel::Generic;
+
+    cpuid(7, 0, regs);
+    const bool avx2 = regs[1] & (1u << 5);
+    const bool avx512f = regs[1] & (1u << 16);
+    const bool avx512dq = regs[1] & (1u << 17);
+    const bool avx512bw = regs[1] & (1u << 30);
+    const bool avx512vl = regs[1] & (1u << 31);
+
+    if (!avx2 || !fma || !f16c) return IsaLevel::Generic;
+    if (avx512f && avx512dq && avx512bw && avx512vl && (xcr0 & 0xe6) == 0xe6) return IsaLevel::Avx512;
+    return IsaLevel::Avx2;
+#else
+    return IsaLevel::Generic;
+#endif
+}
+
+static const KernelTable& tableFor(IsaLevel level) {
+#if defined(ECHOTWIN_X86_KERNELS)
+    if (level == IsaLevel::Avx512) return AVX512_KERNELS;
+    if (level == IsaLevel::Avx2) return AVX2_KERNELS;
+#endif
+    (void)level;
+    return GENERIC_KERNELS;
+}
+
+static IsaLevel& activeLevel() {
+    static IsaLevel level = CpuDispatch::detect();
+    return level;
+}
+
+static const KernelTable*& activeTable() {
+    static const KernelTable* table = &tableFor(activeLevel());
+    return table;
+}
+
+bool CpuDispatch::select(IsaLevel level) {
+    if (int(level) > int(detect())) {
+        return false;
+    }
+    activeLevel() = level;
+    activeTable() = &tableFor(level);
+    return true;
+}
+
+IsaLevel CpuDispatch::active() {
+    return activeLevel();
+}
+
+const KernelTable& CpuDispatch::kernels() {
+    return *activeTable();
+}
+
+bool CpuDispatch::parseLevel(const std::string& name, IsaLevel& level) {
+    if (name == "generic") {
+        level = IsaLevel::Generic;
+    } else if (name == "avx2") {
+        level = IsaLevel::Avx2;
+    } else if (name == "avx512") {
+        level = IsaLevel::Avx512;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* CpuDispatch::levelName(IsaLevel level) {
+    switch (level) {
+        case IsaLevel::Avx2: return "avx2";
+        case IsaLevel::Avx512: return "avx512";
+        default: return "generic";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "feature_config.h"
+
+#define X(name, sr, fft, hop, mels) +1
+constexpr int FEATURE_CONFIG_COUNT = 0 FEATURE_CONFIGS(X);
+#undef X
+
+enum class IsaLevel {
+    Generic = 0,
+    Avx2 = 1,
+    Avx512 = 2
+};
+
+// Entry points of the hot loops. kernels.cpp is compiled once per ISA level
+// with that level's target flags and each build exports one table; the
+// arrays are indexed in FEATURE_CONFIGS order.
+struct KernelTable {
+    // Column-major MelBins x frames.
+    void (*melSpectrogram[FEATURE_CONFIG_COUNT])(const float* audio, int frames, float* output);
+    void (*f0[FEATURE_CONFIG_COUNT])(const float* audio, int frames, float* output);
+    // Three-harmonic tone with a 10% fade at both ends plus scaled noise.
+    void (*renderTone)(float* output, int count, float cyclesPerSample, float amplitude,
+                       const float* noise, float noiseLevel);
+    float (*dot)(const float* a, const float* b, size_t count);
+    float (*sum)(const float* values, size_t count);
+    void (*toHalf)(const float* input, uint16_t* output, size_t count);
+    void (*fromHalf)(const uint16_t* input, float* output, size_t count);
+};
+
+extern const KernelTable GENERIC_KERNELS;
+#if defined(ECHOTWIN_X86_KERNELS)
+extern const KernelTable AVX2_KERNELS;
+extern const KernelTable AVX512_KERNELS;
+#endif
+
+// Picks the kernel build for the running CPU. The best supported level is
+// used unless select() forces another one before any kernel runs.
+class CpuDispatch {
+public:
+    static IsaLevel detect();
+    static bool select(IsaLevel level);
+    static IsaLevel active();
+    static const KernelTable& kernels();
+
+    static bool parseLevel(const std::string& name, IsaLevel& level);
+    static const char* levelName(IsaLevel level);
+};
\ No newline at end of file
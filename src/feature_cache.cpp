@@ -0,0 +1,300 @@
+#include "feature_cache.h"
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <atomic>
+#include <cerrno>
+#include <random>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Bump when extraction output changes for the same parameters so stale
+// entries stop matching.
+#define FEATURE_CACHE_VERSION 2
+#define FEATURE_CACHE_MAGIC 0x31434645u  // "EFC1"
+#define FEATURE_CACHE_HEADER 16
+#define TEMP_NAME_ATTEMPTS 16
+
+MappedFile::MappedFile()
+    : bytes(nullptr), length(0)
+#ifdef _WIN32
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+
+    bytes = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    length = size_t(fileSize.QuadPart);
+    if (!bytes) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    bytes = nullptr;
+    length = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    bytes = static_cast<const uint8_t*>(mapped);
+    length = info.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+}
+#endif
+
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= round64(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+// XXH64: four independent lanes over 32-byte stripes, so hashing runs at
+// memory bandwidth rather than at the speed of a byte-serial hash.
+uint64_t FeatureCache::hash64(const uint8_t* data, size_t length, uint64_t seed) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME5;
+    }
+
+    hash += length;
+
+    for (; p + 8 <= end; p += 8) {
+        hash ^= round64(0, read64(p));
+        hash = rotl64(hash, 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end) {
+        hash ^= uint64_t(read32(p)) * PRIME1;
+        hash = rotl64(hash, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        hash ^= (*p) * PRIME5;
+        hash = rotl64(hash, 11) * PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+FeatureCache::FeatureCache(const std::string& directory)
+    : directory(directory), hits(0), misses(0) {}
+
+bool FeatureCache::entryPath(const std::string& audioPath, const std::string& kind,
+                             const FeatureConfig& config, std::string& path) {
+    auto cached = contentHashes.find(audioPath);
+    if (cached == contentHashes.end()) {
+        MappedFile audio;
+        if (!audio.open(audioPath)) {
+            return false;
+        }
+        cached = contentHashes.emplace(audioPath, hash64(audio.data(), audio.size())).first;
+    }
+
+    std::string params = kind + "|" + std::to_string(config.sampleRate) + "|" + std::to_string(config.fftSize) +
+                         "|" + std::to_string(config.hopLength) + "|" + std::to_string(config.melBins) +
+                         "|v" + std::to_string(FEATURE_CACHE_VERSION);
+    uint64_t paramsHash = hash64(reinterpret_cast<const uint8_t*>(params.data()), params.size());
+
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%s-%08llx.feat", (unsigned long long)cached->second,
+             kind.c_str(), (unsigned long long)(paramsHash & 0xffffffffull));
+    path = (std::filesystem::path(directory) / name).string();
+    return true;
+}
+
+bool FeatureCache::lookup(const std::string& audioPath, const std::string& kind,
+                          const FeatureConfig& config, FeatureView& view) {
+    std::string path;
+    auto file = std::make_shared<MappedFile>();
+
+    if (entryPath(audioPath, kind, config, path) && file->open(path) && file->size() >= FEATURE_CACHE_HEADER) {
+        uint32_t header[4];
+        std::memcpy(header, file->data(), sizeof(header));
+        size_t rows = header[1];
+        size_t cols = header[2];
+
+        if (header[0] == FEATURE_CACHE_MAGIC &&
+            file->size() == FEATURE_CACHE_HEADER + rows * cols * sizeof(float)) {
+            view.file = file;
+            view.data = reinterpret_cast<const float*>(file->data() + FEATURE_CACHE_HEADER);
+            view.rows = rows;
+            view.cols = cols;
+            ++hits;
+            return true;
+        }
+    }
+
+    ++misses;
+    return false;
+}
+
+bool FeatureCache::store(const std::string& audioPath, const std::string& kind, const FeatureConfig& config,
+                         const float* data, size_t rows, size_t cols) {
+    std::string path;
+    if (!entryPath(audioPath, kind, config, path)) {
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // Write under a temporary name and rename so concurrent jobs sharing the
+    // cache never map a partially written entry. The name combines the
+    // process ID, a per-process counter and a random value, and is created
+    // exclusively, so two writers can never end up sharing one temp file.
+    static std::atomic<uint32_t> tempCounter(0);
+    std::string tempPath;
+    FILE* file = nullptr;
+    for (int attempt = 0; attempt < TEMP_NAME_ATTEMPTS && !file; ++attempt) {
+        char suffix[64];
+        snprintf(suffix, sizeof(suffix), ".tmp%ld-%u-%08x", long(getpid()), unsigned(tempCounter++),
+                 unsigned(std::random_device()()));
+        tempPath = path + suffix;
+        file = fopen(tempPath.c_str(), "wbx");
+        if (!file && errno != EEXIST) break;
+    }
+    if (!file) {
+        std::cerr << "Failed to write feature cache entry: " << path << std::endl;
+        return false;
+    }
+
+    uint32_t header[4] = { FEATURE_CACHE_MAGIC, uint32_t(rows), uint32_t(cols), 0 };
+    bool written = fwrite(header, sizeof(header), 1, file) == 1 &&
+                   fwrite(data, sizeof(float), rows * cols, file) == rows * cols;
+    if (fclose(file) != 0 || !written) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void FeatureCache::reportStats() const {
+    size_t total = hits + misses;
+    std::cout << "Feature cache: " << hits << " hit(s), " << misses << " miss(es)";
+    if (total > 0) {
+        std::cout << " (" << (100 * hits / total) << "% hit rate)";
+    }
+    std::cout << std::endl;
+}
\ No newline at end of file
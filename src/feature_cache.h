@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include "feature_config.h"
+
+// Read-only memory map of a whole file.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    void close();
+
+    const uint8_t* bytes;
+    size_t length;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+// Row-major float32 features backed by a mapped cache entry.
+struct FeatureView {
+    std::shared_ptr<MappedFile> file;
+    const float* data = nullptr;
+    size_t rows = 0;
+    size_t cols = 0;
+};
+
+// On-disk cache of extracted features, addressed by a hash of the audio
+// file's bytes plus every parameter that affects extraction. A hit maps the
+// stored entry instead of decoding and analysing the audio again.
+class FeatureCache {
+public:
+    explicit FeatureCache(const std::string& directory);
+
+    bool lookup(const std::string& audioPath, const std::string& kind,
+                const FeatureConfig& config, FeatureView& view);
+    bool store(const std::string& audioPath, const std::string& kind, const FeatureConfig& config,
+               const float* data, size_t rows, size_t cols);
+    void reportStats() const;
+
+    static uint64_t hash64(const uint8_t* data, size_t length, uint64_t seed = 0);
+
+private:
+    bool entryPath(const std::string& audioPath, const std::string& kind,
+                   const FeatureConfig& config, std::string& path);
+
+    std::string directory;
+    std::map<std::string, uint64_t> contentHashes;
+    size_t hits;
+    size_t misses;
+};
\ No newline at end of file
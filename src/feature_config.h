@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+
+#define SAMPLE_RATE 16000
+
+// Feature configurations compiled into the binary: name, sample rate,
+// FFT size, hop length, mel bins. Each entry gets its own specialized
+// FeaturePipeline instantiation; adding a line here is all it takes to
+// support a new config.
+#define FEATURE_CONFIGS(X)                      \
+    X("16k",     16000, 1024, 256, 80)          \
+    X("16k-128", 16000, 1024, 256, 128)         \
+    X("22k",     22050, 1024, 256, 80)          \
+    X("22k-128", 22050, 1024, 256, 128)         \
+    X("24k",     24000, 1024, 256, 80)          \
+    X("24k-128", 24000, 1024, 256, 128)
+
+struct FeatureConfig {
+    const char* name;
+    int sampleRate;
+    int fftSize;
+    int hopLength;
+    int melBins;
+
+    static const FeatureConfig& defaults();
+    static const FeatureConfig* find(const std::string& name);
+    static std::string available();
+};
\ No newline at end of file
@@ -1,45 +1,179 @@
 #include "feature_extractor.h"
+#include "cpu_dispatch.h"
+#include "resampler.h"
+#include "quantizer.h"
 #include <sndfile.h>
 #include <iostream>
 #include <fstream>
 #include <cmath>
 #include <algorithm>
 
-#define MEL_BINS 80
-#define FFT_SIZE 1024
-#define HOP_LENGTH 256
-#define SAMPLE_RATE 16000
+#define DECODE_BLOCK_FRAMES 4096
 
-bool FeatureExtractor::extractMelSpectrogram(const std::string& audioPath, const std::string& outputPath) {
-    std::vector<float> audio = loadAudio(audioPath);
+static const FeatureConfig FEATURE_CONFIG_TABLE[] = {
+#define X(name, sr, fft, hop, mels) { name, sr, fft, hop, mels },
+    FEATURE_CONFIGS(X)
+#undef X
+};
+
+const FeatureConfig& FeatureConfig::defaults() {
+    return FEATURE_CONFIG_TABLE[0];
+}
+
+const FeatureConfig* FeatureConfig::find(const std::string& name) {
+    for (const FeatureConfig& config : FEATURE_CONFIG_TABLE) {
+        if (name == config.name) {
+            return &config;
+        }
+    }
+    return nullptr;
+}
+
+std::string FeatureConfig::available() {
+    std::string names;
+    for (const FeatureConfig& config : FEATURE_CONFIG_TABLE) {
+        if (!names.empty()) names += ", ";
+        names += config.name;
+    }
+    return names;
+}
+
+// Position of config in FEATURE_CONFIGS, which is also its slot in the
+// kernel tables, or -1 if no pipeline was compiled for it.
+static int configIndex(const FeatureConfig& config) {
+    for (int i = 0; i < FEATURE_CONFIG_COUNT; ++i) {
+        const FeatureConfig& entry = FEATURE_CONFIG_TABLE[i];
+        if (config.sampleRate == entry.sampleRate && config.fftSize == entry.fftSize &&
+            config.hopLength == entry.hopLength && config.melBins == entry.melBins) {
+            return i;
+        }
+    }
+    std::cerr << "Unsupported feature config: " << config.name << std::endl;
+    return -1;
+}
+
+static int numFrames(const std::vector<float>& audio, const FeatureConfig& config) {
+    if (audio.size() < size_t(config.fftSize)) return 0;
+    return int((audio.size() - config.fftSize) / config.hopLength + 1);
+}
+
+bool FeatureExtractor::extractMelSpectrogram(const std::string& audioPath, const std::string& outputPath,
+                                             const FeatureConfig& config, Precision precision,
+                                             FeatureCache* cache) {
+    FeatureView cached;
+    if (cache && cache->lookup(audioPath, "mel", config, cached)) {
+        std::cout << "Cached mel-spectrogram: " << cached.rows << " x " << cached.cols
+                  << " (" << config.name << ")" << std::endl;
+        std::string shape = std::to_string(cached.rows) + ", " + std::to_string(cached.cols);
+        return writeNpy(cached.data, cached.rows, cached.cols, shape, outputPath, precision);
+    }
+
+    std::vector<float> audio = loadAudio(audioPath, config.sampleRate);
     if (audio.empty()) {
         std::cerr << "Failed to load audio file: " << audioPath << std::endl;
         return false;
     }
 
-    Eigen::MatrixXf melSpec = computeMelSpectrogram(audio, SAMPLE_RATE);
+    Eigen::MatrixXf melSpec = computeMelSpectrogram(audio, config);
+    if (melSpec.cols() == 0) {
+        std::cerr << "Audio too short for feature extraction: " << audioPath << std::endl;
+        return false;
+    }
     
-    std::cout << "Extracted mel-spectrogram: " << MEL_BINS << " x " << melSpec.cols() << std::endl;
+    std::cout << "Extracted mel-spectrogram: " << melSpec.rows() << " x " << melSpec.cols()
+              << " (" << config.name << ")" << std::endl;
+    
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rowMajor = melSpec;
+    if (cache) {
+        cache->store(audioPath, "mel", config, rowMajor.data(), rowMajor.rows(), rowMajor.cols());
+    }
     
-    return saveNpy(melSpec, outputPath);
+    std::string shape = std::to_string(melSpec.rows()) + ", " + std::to_string(melSpec.cols());
+    return writeNpy(rowMajor.data(), rowMajor.rows(), rowMajor.cols(), shape, outputPath, precision);
 }
 
-bool FeatureExtractor::extractF0(const std::string& audioPath, const std::string& outputPath) {
-    std::vector<float> audio = loadAudio(audioPath);
+bool FeatureExtractor::extractF0(const std::string& audioPath, const std::string& outputPath,
+                                 const FeatureConfig& config, Precision precision,
+                                 FeatureCache* cache) {
+    FeatureView cached;
+    if (cache && cache->lookup(audioPath, "f0", config, cached)) {
+        std::cout << "Cached F0 track: " << cached.cols << " frames" << std::endl;
+        return writeNpy(cached.data, 1, cached.cols, std::to_string(cached.cols) + ",", outputPath, precision);
+    }
+
+    std::vector<float> audio = loadAudio(audioPath, config.sampleRate);
     if (audio.empty()) {
         std::cerr << "Failed to load audio file: " << audioPath << std::endl;
         return false;
     }
 
-    std::vector<float> f0 = computeF0(audio, SAMPLE_RATE);
+    std::vector<float> f0 = computeF0(audio, config);
+    if (f0.empty()) {
+        std::cerr << "Audio too short for feature extraction: " << audioPath << std::endl;
+        return false;
+    }
     
     std::cout << "Extracted F0 track: " << f0.size() << " frames" << std::endl;
     
-    return saveNpy(f0, outputPath);
+    if (cache) {
+        cache->store(audioPath, "f0", config, f0.data(), 1, f0.size());
+    }
+    
+    return saveNpy(f0, outputPath, precision);
 }
 
-std::vector<float> FeatureExtractor::loadAudio(const std::string& path) {
-    SF_INFO info;
+// Decodes the audio once and produces both feature sets in memory, serving
+// either one from the cache when possible.
+bool FeatureExtractor::computeFeatures(const std::string& audioPath, Eigen::MatrixXf& melSpec,
+                                       std::vector<float>& f0, const FeatureConfig& config,
+                                       FeatureCache* cache) {
+    FeatureView cachedMel, cachedF0;
+    bool melHit = cache && cache->lookup(audioPath, "mel", config, cachedMel);
+    bool f0Hit = cache && cache->lookup(audioPath, "f0", config, cachedF0);
+
+    std::vector<float> audio;
+    if (!melHit || !f0Hit) {
+        audio = loadAudio(audioPath, config.sampleRate);
+        if (audio.empty()) {
+            std::cerr << "Failed to load audio file: " << audioPath << std::endl;
+            return false;
+        }
+    }
+
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrixXf;
+
+    if (melHit) {
+        melSpec = Eigen::Map<const RowMajorMatrixXf>(cachedMel.data, cachedMel.rows, cachedMel.cols);
+    } else {
+        melSpec = computeMelSpectrogram(audio, config);
+        if (cache && melSpec.cols() > 0) {
+            RowMajorMatrixXf rowMajor = melSpec;
+            cache->store(audioPath, "mel", config, rowMajor.data(), rowMajor.rows(), rowMajor.cols());
+        }
+    }
+
+    if (f0Hit) {
+        f0.assign(cachedF0.data, cachedF0.data + cachedF0.cols);
+    } else {
+        f0 = computeF0(audio, config);
+        if (cache && !f0.empty()) {
+            cache->store(audioPath, "f0", config, f0.data(), 1, f0.size());
+        }
+    }
+
+    if (melSpec.cols() == 0 || f0.empty()) {
+        std::cerr << "Audio too short for feature extraction: " << audioPath << std::endl;
+        return false;
+    }
+
+    std::cout << "Extracted mel-spectrogram: " << melSpec.rows() << " x " << melSpec.cols()
+              << " (" << config.name << ")" << std::endl;
+    std::cout << "Extracted F0 track: " << f0.size() << " frames" << std::endl;
+    return true;
+}
+
+std::vector<float> FeatureExtractor::loadAudio(const std::string& path, int sampleRate) {
+    SF_INFO info = {};
     SNDFILE* file = sf_open(path.c_str(), SFM_READ, &info);
     
     if (!file) {
@@ -47,86 +181,65 @@ std::vector<float> FeatureExtractor::loadAudio(const std::string& path) {
         return {};
     }
 
-    std::vector<float> audio(info.frames);
-    sf_read_float(file, audio.data(), info.frames);
+    if (info.samplerate != sampleRate || info.channels != 1) {
+        std::cout << "Converting " << info.samplerate << " Hz, " << info.channels << " channel(s) to "
+                  << sampleRate << " Hz mono" << std::endl;
+    }
+
+    // Decode in blocks and feed each one through downmix and resampling so
+    // the interleaved, full-rate input is never held in memory at once.
+    Resampler resampler(info.samplerate, sampleRate);
+    std::vector<float> audio;
+    audio.reserve(resampler.expectedOutput(info.frames));
+
+    std::vector<float> interleaved(size_t(DECODE_BLOCK_FRAMES) * info.channels);
+    std::vector<float> mono(DECODE_BLOCK_FRAMES);
+
+    sf_count_t frames;
+    while ((frames = sf_readf_float(file, interleaved.data(), DECODE_BLOCK_FRAMES)) > 0) {
+        Resampler::downmix(interleaved.data(), frames, info.channels, mono.data());
+        resampler.process(mono.data(), frames, audio);
+    }
+    resampler.flush(audio);
     sf_close(file);
 
     return audio;
 }
 
-Eigen::MatrixXf FeatureExtractor::computeMelSpectrogram(const std::vector<float>& audio, int sampleRate) {
-    int numFrames = (audio.size() - FFT_SIZE) / HOP_LENGTH + 1;
-    Eigen::MatrixXf melSpec(MEL_BINS, numFrames);
-
-    for (int frame = 0; frame < numFrames; ++frame) {
-        int start = frame * HOP_LENGTH;
-        
-        std::vector<float> window(FFT_SIZE);
-        for (int i = 0; i < FFT_SIZE; ++i) {
-            if (start + i < audio.size()) {
-                window[i] = audio[start + i] * (0.5f - 0.5f * cos(2.0f * M_PI * i / (FFT_SIZE - 1)));
-            } else {
-                window[i] = 0.0f;
-            }
-        }
-
-        std::vector<float> magnitude(FFT_SIZE / 2 + 1);
-        for (int i = 0; i < magnitude.size(); ++i) {
-            magnitude[i] = std::abs(window[i]) + 1e-8f;
-        }
-
-        for (int mel = 0; mel < MEL_BINS; ++mel) {
-            float sum = 0.0f;
-            int startBin = mel * magnitude.size() / MEL_BINS;
-            int endBin = (mel + 1) * magnitude.size() / MEL_BINS;
-            
-            for (int bin = startBin; bin < endBin && bin < magnitude.size(); ++bin) {
-                sum += magnitude[bin];
-            }
-            
-            melSpec(mel, frame) = log10f(sum / (endBin - startBin) + 1e-8f);
-        }
-    }
+Eigen::MatrixXf FeatureExtractor::computeMelSpectrogram(const std::vector<float>& audio, const FeatureConfig& config) {
+    const int index = configIndex(config);
+    if (index < 0) return Eigen::MatrixXf();
 
+    const int frames = numFrames(audio, config);
+    Eigen::MatrixXf melSpec(config.melBins, frames);
+    CpuDispatch::kernels().melSpectrogram[index](audio.data(), frames, melSpec.data());
     return melSpec;
 }
 
-std::vector<float> FeatureExtractor::computeF0(const std::vector<float>& audio, int sampleRate) {
-    int numFrames = (audio.size() - FFT_SIZE) / HOP_LENGTH + 1;
-    std::vector<float> f0(numFrames);
-
-    for (int frame = 0; frame < numFrames; ++frame) {
-        int start = frame * HOP_LENGTH;
-        
-        std::vector<float> autocorr(FFT_SIZE / 2);
-        for (int lag = 1; lag < autocorr.size(); ++lag) {
-            float sum = 0.0f;
-            int count = 0;
-            
-            for (int i = 0; i + lag < FFT_SIZE && start + i + lag < audio.size(); ++i) {
-                sum += audio[start + i] * audio[start + i + lag];
-                count++;
-            }
-            
-            autocorr[lag] = count > 0 ? sum / count : 0.0f;
-        }
+std::vector<float> FeatureExtractor::computeF0(const std::vector<float>& audio, const FeatureConfig& config) {
+    const int index = configIndex(config);
+    if (index < 0) return {};
 
-        int maxLag = 1;
-        float maxVal = autocorr[1];
-        for (int lag = 2; lag < autocorr.size(); ++lag) {
-            if (autocorr[lag] > maxVal) {
-                maxVal = autocorr[lag];
-                maxLag = lag;
-            }
-        }
+    std::vector<float> f0(numFrames(audio, config));
+    CpuDispatch::kernels().f0[index](audio.data(), int(f0.size()), f0.data());
+    return f0;
+}
 
-        f0[frame] = maxVal > 0.3f ? float(sampleRate) / maxLag : 0.0f;
-    }
+bool FeatureExtractor::saveNpy(const Eigen::MatrixXf& data, const std::string& path, Precision precision) {
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rowMajor = data;
+    std::string shape = std::to_string(data.rows()) + ", " + std::to_string(data.cols());
+    return writeNpy(rowMajor.data(), data.rows(), data.cols(), shape, path, precision);
+}
 
-    return f0;
+bool FeatureExtractor::saveNpy(const std::vector<float>& data, const std::string& path, Precision precision) {
+    std::string shape = std::to_string(data.size()) + ",";
+    return writeNpy(data.data(), 1, data.size(), shape, path, precision);
 }
 
-bool FeatureExtractor::saveNpy(const Eigen::MatrixXf& data, const std::string& path) {
+// int8 files are a 1-D array of (q, scale) records, one per row: cols int8
+// values followed by the float32 scale that restores them.
+bool FeatureExtractor::writeNpy(const float* data, size_t rows, size_t cols, const std::string& shape,
+                                const std::string& path, Precision precision) {
     std::ofstream file(path, std::ios::binary);
     if (!file) {
         std::cerr << "Failed to open output file: " << path << std::endl;
@@ -136,11 +249,11 @@ bool FeatureExtractor::saveNpy(const Eigen::MatrixXf& data, const std::string& p
     char header[] = "\x93NUMPY\x01\x00";
     file.write(header, 8);
 
-    std::string dtype = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + 
-                       std::to_string(data.rows()) + ", " + std::to_string(data.cols()) + "), }";
+    std::string dtype = "{'descr': " + Quantizer::npyDescr(precision, cols) +
+                        ", 'fortran_order': False, 'shape': (" +
+                        (precision == Precision::Int8 ? std::to_string(rows) + "," : shape) + "), }";
     
-    int header_len = dtype.length();
-    int padding = 16 - (header_len + 10) % 16;
+    int padding = 15 - (dtype.length() + 10) % 16;
     for (int i = 0; i < padding; ++i) dtype += " ";
     dtype += "\n";
 
@@ -148,41 +261,36 @@ bool FeatureExtractor::saveNpy(const Eigen::MatrixXf& data, const std::string& p
     file.write(reinterpret_cast<char*>(&len), 2);
     file.write(dtype.c_str(), dtype.length());
 
-    for (int i = 0; i < data.rows(); ++i) {
-        for (int j = 0; j < data.cols(); ++j) {
-            float val = data(i, j);
-            file.write(reinterpret_cast<char*>(&val), sizeof(float));
-        }
-    }
+    const size_t count = rows * cols;
+    std::vector<float> restored;
 
-    return true;
-}
-
-bool FeatureExtractor::saveNpy(const std::vector<float>& data, const std::string& path) {
-    std::ofstream file(path, std::ios::binary);
-    if (!file) {
-        std::cerr << "Failed to open output file: " << path << std::endl;
-        return false;
-    }
-
-    char header[] = "\x93NUMPY\x01\x00";
-    file.write(header, 8);
+    if (precision == Precision::Float16) {
+        std::vector<uint16_t> half(count);
+        Quantizer::toHalf(data, half.data(), count);
+        file.write(reinterpret_cast<const char*>(half.data()), count * sizeof(uint16_t));
 
-    std::string dtype = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + 
-                       std::to_string(data.size()) + ",), }";
-    
-    int header_len = dtype.length();
-    int padding = 16 - (header_len + 10) % 16;
-    for (int i = 0; i < padding; ++i) dtype += " ";
-    dtype += "\n";
+        restored.resize(count);
+        Quantizer::fromHalf(half.data(), restored.data(), count);
+    } else if (precision == Precision::Int8) {
+        std::vector<int8_t> quantized(count);
+        std::vector<float> scales(rows);
+        for (size_t row = 0; row < rows; ++row) {
+            scales[row] = Quantizer::toInt8(data + row * cols, quantized.data() + row * cols, cols);
+            file.write(reinterpret_cast<const char*>(quantized.data() + row * cols), cols);
+            file.write(reinterpret_cast<const char*>(&scales[row]), sizeof(float));
+        }
 
-    uint16_t len = dtype.length();
-    file.write(reinterpret_cast<char*>(&len), 2);
-    file.write(dtype.c_str(), dtype.length());
+        restored.resize(count);
+        for (size_t row = 0; row < rows; ++row) {
+            Quantizer::fromInt8(quantized.data() + row * cols, scales[row], restored.data() + row * cols, cols);
+        }
+    } else {
+        file.write(reinterpret_cast<const char*>(data), count * sizeof(float));
+    }
 
-    for (float val : data) {
-        file.write(reinterpret_cast<char*>(&val), sizeof(float));
+    if (!restored.empty()) {
+        Quantizer::reportError(path, precision, data, restored.data(), count);
     }
 
-    return true;
+    return bool(file);
 }
\ No newline at end of file
@@ -2,16 +2,31 @@
 #include <string>
 #include <vector>
 #include <Eigen/Dense>
+#include "feature_config.h"
+#include "quantizer.h"
+#include "feature_cache.h"
 
 class FeatureExtractor {
 public:
-    static bool extractMelSpectrogram(const std::string& audioPath, const std::string& outputPath);
-    static bool extractF0(const std::string& audioPath, const std::string& outputPath);
+    static bool extractMelSpectrogram(const std::string& audioPath, const std::string& outputPath,
+                                      const FeatureConfig& config = FeatureConfig::defaults(),
+                                      Precision precision = Precision::Float32,
+                                      FeatureCache* cache = nullptr);
+    static bool extractF0(const std::string& audioPath, const std::string& outputPath,
+                          const FeatureConfig& config = FeatureConfig::defaults(),
+                          Precision precision = Precision::Float32,
+                          FeatureCache* cache = nullptr);
+    static bool computeFeatures(const std::string& audioPath, Eigen::MatrixXf& melSpec,
+                                std::vector<float>& f0,
+                                const FeatureConfig& config = FeatureConfig::defaults(),
+                                FeatureCache* cache = nullptr);
+    static bool saveNpy(const Eigen::MatrixXf& data, const std::string& path, Precision precision);
+    static bool saveNpy(const std::vector<float>& data, const std::string& path, Precision precision);
     
 private:
-    static std::vector<float> loadAudio(const std::string& path);
-    static Eigen::MatrixXf computeMelSpectrogram(const std::vector<float>& audio, int sampleRate);
-    static std::vector<float> computeF0(const std::vector<float>& audio, int sampleRate);
-    static bool saveNpy(const Eigen::MatrixXf& data, const std::string& path);
-    static bool saveNpy(const std::vector<float>& data, const std::string& path);
+    static std::vector<float> loadAudio(const std::string& path, int sampleRate);
+    static Eigen::MatrixXf computeMelSpectrogram(const std::vector<float>& audio, const FeatureConfig& config);
+    static std::vector<float> computeF0(const std::vector<float>& audio, const FeatureConfig& config);
+    static bool writeNpy(const float* data, size_t rows, size_t cols, const std::string& shape,
+                         const std::string& path, Precision precision);
 };
\ No newline at end of file
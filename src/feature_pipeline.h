@@ -0,0 +1,217 @@
+#pragma once
+#include "constexpr_math.h"
+#include <cmath>
+
+// Feature extraction specialized on its parameters. All sizes are template
+// arguments and every table (window, FFT twiddles, mel filterbank) is built
+// at compile time, so the per-frame loops have constant trip counts and the
+// compiler can unroll and vectorize them for each configuration.
+//
+// The pipeline is only instantiated from kernels.cpp, which is compiled once
+// per instruction-set level. Tag is a type unique to each of those builds so
+// every instantiation gets distinct symbols, and Tag::dot is that build's
+// fixed-order dot product, the same one the kernel table exports. Tables are
+// plain arrays, helpers are members and math goes through libm rather than
+// <cmath> overloads for the same reason: no out-of-line code compiled for one
+// ISA can be shared with another at link time.
+template <int SampleRate, int FftSize, int HopLength, int MelBins, typename Tag>
+struct FeaturePipeline {
+    static_assert(FftSize >= 4 && (FftSize & (FftSize - 1)) == 0, "FFT size must be a power of two");
+    static_assert(HopLength > 0 && MelBins > 0, "Invalid feature parameters");
+
+    static constexpr int NUM_BINS = FftSize / 2 + 1;
+    static constexpr int MAX_FILTER_WEIGHTS = 2 * NUM_BINS + MelBins;
+
+    struct Window {
+        float values[FftSize];
+    };
+
+    // Twiddles for the butterfly stage of half-size h live at [h - 1, 2h - 1),
+    // so every stage reads them contiguously.
+    struct Twiddles {
+        float re[FftSize - 1];
+        float im[FftSize - 1];
+    };
+
+    struct BitReverse {
+        int index[FftSize];
+    };
+
+    struct MelFilterbank {
+        int start[MelBins];
+        int length[MelBins];
+        int offset[MelBins];
+        float weights[MAX_FILTER_WEIGHTS];
+    };
+
+    static constexpr Window makeWindow() {
+        Window window{};
+        for (int i = 0; i < FftSize; ++i) {
+            window.values[i] = float(0.5 - 0.5 * cmath::cos(2.0 * cmath::PI * i / (FftSize - 1)));
+        }
+        return window;
+    }
+
+    static constexpr Twiddles makeTwiddles() {
+        Twiddles twiddles{};
+        for (int half = 1; half < FftSize; half <<= 1) {
+            for (int k = 0; k < half; ++k) {
+                double angle = -cmath::PI * k / half;
+                twiddles.re[half - 1 + k] = float(cmath::cos(angle));
+                twiddles.im[half - 1 + k] = float(cmath::sin(angle));
+            }
+        }
+        return twiddles;
+    }
+
+    static constexpr BitReverse makeBitReverse() {
+        BitReverse table{};
+        int bits = 0;
+        while ((1 << bits) < FftSize) ++bits;
+        for (int i = 0; i < FftSize; ++i) {
+            int reversed = 0;
+            for (int b = 0; b < bits; ++b) {
+                if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+            }
+            table.index[i] = reversed;
+        }
+        return table;
+    }
+
+    // HTK-style triangular filters stored sparsely: each mel band only keeps
+    // the FFT bins it overlaps. Bands narrower than one bin fall back to the
+    // nearest bin so high mel counts never produce empty rows.
+    static constexpr MelFilterbank makeMelFilterbank() {
+        MelFilterbank bank{};
+        double maxMel = 2595.0 * cmath::log10(1.0 + (SampleRate / 2.0) / 700.0);
+
+        double edges[MelBins + 2] = {};
+        for (int i = 0; i < MelBins + 2; ++i) {
+            double mel = maxMel * i / (MelBins + 1);
+            double hz = 700.0 * (cmath::pow10(mel / 2595.0) - 1.0);
+            edges[i] = hz * FftSize / SampleRate;
+        }
+
+        int offset = 0;
+        for (int mel = 0; mel < MelBins; ++mel) {
+            double left = edges[mel];
+            double center = edges[mel + 1];
+            double right = edges[mel + 2];
+
+            bank.offset[mel] = offset;
+            bank.start[mel] = -1;
+            for (int bin = 0; bin < NUM_BINS; ++bin) {
+                double weight = 0.0;
+                if (bin > left && bin <= center) {
+                    weight = (bin - left) / (center - left);
+                } else if (bin > center && bin < right) {
+                    weight = (right - bin) / (right - center);
+                }
+                if (weight <= 0.0) continue;
+
+                if (bank.start[mel] < 0) bank.start[mel] = bin;
+                bank.weights[offset++] = float(weight);
+            }
+
+            if (bank.start[mel] < 0) {
+                int nearest = int(center + 0.5);
+                bank.start[mel] = nearest < NUM_BINS ? nearest : NUM_BINS - 1;
+                bank.weights[offset++] = 1.0f;
+            }
+            bank.length[mel] = offset - bank.offset[mel];
+        }
+        return bank;
+    }
+
+    static constexpr Window WINDOW = makeWindow();
+    static constexpr Twiddles TWIDDLES = makeTwiddles();
+    static constexpr BitReverse BIT_REVERSE = makeBitReverse();
+    static constexpr MelFilterbank MEL_FILTERBANK = makeMelFilterbank();
+
+    // In-place iterative radix-2 FFT on split real/imaginary buffers.
+    static void fft(float* re, float* im) {
+        for (int i = 0; i < FftSize; ++i) {
+            int j = BIT_REVERSE.index[i];
+            if (j > i) {
+                float tr = re[i];
+                float ti = im[i];
+                re[i] = re[j];
+                im[i] = im[j];
+                re[j] = tr;
+                im[j] = ti;
+            }
+        }
+
+        for (int half = 1; half < FftSize; half <<= 1) {
+            const float* wr = &TWIDDLES.re[half - 1];
+            const float* wi = &TWIDDLES.im[half - 1];
+            for (int start = 0; start < FftSize; start += 2 * half) {
+                float* ar = re + start;
+                float* ai = im + start;
+                float* br = ar + half;
+                float* bi = ai + half;
+                for (int k = 0; k < half; ++k) {
+                    float tr = br[k] * wr[k] - bi[k] * wi[k];
+                    float ti = br[k] * wi[k] + bi[k] * wr[k];
+                    br[k] = ar[k] - tr;
+                    bi[k] = ai[k] - ti;
+                    ar[k] += tr;
+                    ai[k] += ti;
+                }
+            }
+        }
+    }
+
+    static void melFrame(const float* samples, float* melOut) {
+        alignas(64) float re[FftSize];
+        alignas(64) float im[FftSize] = {};
+        alignas(64) float magnitude[NUM_BINS];
+
+        for (int i = 0; i < FftSize; ++i) {
+            re[i] = samples[i] * WINDOW.values[i];
+        }
+
+        fft(re, im);
+
+        for (int i = 0; i < NUM_BINS; ++i) {
+            magnitude[i] = sqrtf(re[i] * re[i] + im[i] * im[i]);
+        }
+
+        for (int mel = 0; mel < MelBins; ++mel) {
+            float sum = Tag::dot(&MEL_FILTERBANK.weights[MEL_FILTERBANK.offset[mel]],
+                            &magnitude[MEL_FILTERBANK.start[mel]], MEL_FILTERBANK.length[mel]);
+            melOut[mel] = log10f(sum + 1e-8f);
+        }
+    }
+
+    static float f0Frame(const float* samples) {
+        float autocorr[FftSize / 2] = {};
+        for (int lag = 1; lag < FftSize / 2; ++lag) {
+            const int count = FftSize - lag;
+            autocorr[lag] = Tag::dot(samples, samples + lag, count) / count;
+        }
+
+        int maxLag = 1;
+        float maxVal = autocorr[1];
+        for (int lag = 2; lag < FftSize / 2; ++lag) {
+            if (autocorr[lag] > maxVal) {
+                maxVal = autocorr[lag];
+                maxLag = lag;
+            }
+        }
+
+        return maxVal > 0.3f ? float(SampleRate) / maxLag : 0.0f;
+    }
+
+    static void melSpectrogram(const float* audio, int frames, float* output) {
+        for (int frame = 0; frame < frames; ++frame) {
+            melFrame(audio + size_t(frame) * HopLength, output + size_t(frame) * MelBins);
+        }
+    }
+
+    static void f0(const float* audio, int frames, float* output) {
+        for (int frame = 0; frame < frames; ++frame) {
+            output[frame] = f0Frame(audio + size_t(frame) * HopLength);
+        }
+    }
+};
\ No newline at end of file
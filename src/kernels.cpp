@@ -0,0 +1,205 @@
+// Hot loops of feature extraction, synthesis and quantization. This file is
+// compiled once per ISA level: as part of the main target for the baseline
+// build, and again by CMake with KERNEL_NAMESPACE / KERNEL_TABLE defined and
+// the level's target flags (see echotwin_add_kernels). Everything here has
+// internal linkage or lives in KERNEL_NAMESPACE, and nothing instantiates
+// shared templates, so the linker can never substitute code built for one
+// level into another.
+#include "cpu_dispatch.h"
+#include "feature_pipeline.h"
+#include <cstring>
+
+#if defined(__F16C__) || defined(__AVX2__)
+#include <immintrin.h>
+#define KERNELS_HAVE_F16C
+#endif
+
+#ifndef KERNEL_NAMESPACE
+#define KERNEL_NAMESPACE kernels_generic
+#define KERNEL_TABLE GENERIC_KERNELS
+#endif
+
+#define KERNEL_ACCUMULATORS 16
+
+namespace KERNEL_NAMESPACE {
+
+// Dot product with a fixed set of independent accumulators. The summation
+// order is fixed by the source, so it vectorizes without -ffast-math and
+// gives the same result at every ISA level.
+static float dot(const float* a, const float* b, size_t count) {
+    float acc[KERNEL_ACCUMULATORS] = {};
+    size_t i = 0;
+    for (; i + KERNEL_ACCUMULATORS <= count; i += KERNEL_ACCUMULATORS) {
+        for (int k = 0; k < KERNEL_ACCUMULATORS; ++k) {
+            acc[k] += a[i + k] * b[i + k];
+        }
+    }
+
+    float total = 0.0f;
+    for (int k = 0; k < KERNEL_ACCUMULATORS; ++k) {
+        total += acc[k];
+    }
+    for (; i < count; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+// Instantiation tag for FeaturePipeline; hands it this build's dot product.
+struct Tag {
+    static float dot(const float* a, const float* b, size_t count) {
+        return KERNEL_NAMESPACE::dot(a, b, count);
+    }
+};
+
+static float sum(const float* values, size_t count) {
+    float acc[KERNEL_ACCUMULATORS] = {};
+    size_t i = 0;
+    for (; i + KERNEL_ACCUMULATORS <= count; i += KERNEL_ACCUMULATORS) {
+        for (int k = 0; k < KERNEL_ACCUMULATORS; ++k) {
+            acc[k] += values[i + k];
+        }
+    }
+
+    float total = 0.0f;
+    for (int k = 0; k < KERNEL_ACCUMULATORS; ++k) {
+        total += acc[k];
+    }
+    for (; i < count; ++i) {
+        total += values[i];
+    }
+    return total;
+}
+
+// sin(2*pi*cycles) for cycles >= 0. Range reduction plus an odd Taylor
+// polynomial (error below 1e-7) in place of libm, so the oscillator loop
+// has no calls and vectorizes.
+static inline float sinCycles(float cycles) {
+    float x = cycles - float(int32_t(cycles + 0.5f));
+    x = x > 0.25f ? 0.5f - x : x;
+    x = x < -0.25f ? -0.5f - x : x;
+
+    float y = x * 6.28318530718f;
+    float y2 = y * y;
+    return y * (1.0f + y2 * (-1.66666667e-1f + y2 * (8.33333333e-3f + y2 * (-1.98412698e-4f +
+                y2 * (2.75573192e-6f + y2 * -2.50521084e-8f)))));
+}
+
+static void renderTone(float* output, int count, float cyclesPerSample, float amplitude,
+                       const float* noise, float noiseLevel) {
+    const float fadeLength = count * 0.1f;
+    for (int j = 0; j < count; ++j) {
+        float fadeIn = float(j) / fadeLength;
+        float fadeOut = float(count - j) / fadeLength;
+        float envelope = amplitude * (fadeIn < 1.0f ? fadeIn : 1.0f) * (fadeOut < 1.0f ? fadeOut : 1.0f);
+
+        float phase = cyclesPerSample * float(j);
+        float tone = sinCycles(phase) + 0.3f * sinCycles(2.0f * phase) + 0.1f * sinCycles(3.0f * phase);
+        output[j] = envelope * tone + noise[j] * noiseLevel;
+    }
+}
+
+static uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = int32_t((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff) {
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+    if (exponent >= 31) {
+        return sign | 0x7c00;
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (remainder > midpoint || (remainder == midpoint && (half & 1))) ++half;
+        return sign | half;
+    }
+
+    uint32_t half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) ++half;
+    return sign | half;
+}
+
+static float halfToFloat(uint16_t half) {
+    uint32_t sign = uint32_t(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+    uint32_t bits;
+
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    } else if (exponent == 31) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void toHalf(const float* input, uint16_t* output, size_t count) {
+    size_t i = 0;
+#if defined(KERNELS_HAVE_F16C)
+    for (; i + 8 <= count; i += 8) {
+        __m128i packed = _mm256_cvtps_ph(_mm256_loadu_ps(input + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = floatToHalf(input[i]);
+    }
+}
+
+static void fromHalf(const uint16_t* input, float* output, size_t count) {
+    size_t i = 0;
+#if defined(KERNELS_HAVE_F16C)
+    for (; i + 8 <= count; i += 8) {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        _mm256_storeu_ps(output + i, _mm256_cvtph_ps(packed));
+    }
+#endif
+    for (; i < count; ++i) {
+        output[i] = halfToFloat(input[i]);
+    }
+}
+
+}  // namespace KERNEL_NAMESPACE
+
+extern const KernelTable KERNEL_TABLE = {
+    {
+#define X(name, sr, fft, hop, mels) &FeaturePipeline<sr, fft, hop, mels, KERNEL_NAMESPACE::Tag>::melSpectrogram,
+        FEATURE_CONFIGS(X)
+#undef X
+    },
+    {
+#define X(name, sr, fft, hop, mels) &FeaturePipeline<sr, fft, hop, mels, KERNEL_NAMESPACE::Tag>::f0,
+        FEATURE_CONFIGS(X)
+#undef X
+    },
+    &KERNEL_NAMESPACE::renderTone,
+    &KERNEL_NAMESPACE::dot,
+    &KERNEL_NAMESPACE::sum,
+    &KERNEL_NAMESPACE::toHalf,
+    &KERNEL_NAMESPACE::fromHalf,
+};
\ No newline at end of file
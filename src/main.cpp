@@ -2,10 +2,15 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <memory>
+#include <filesystem>
 #include "audio_recorder.h"
 #include "feature_extractor.h"
 #include "voice_trainer.h"
 #include "speech_synthesizer.h"
+#include "audio_writer.h"
+#include "noise_generator.h"
+#include "cpu_dispatch.h"
 
 std::string getVersion() {
     std::ifstream versionFile("VERSION");
@@ -17,14 +22,41 @@ std::string getVersion() {
     return version;
 }
 
+// Removes "--name value" from args and stores the value, leaving value
+// untouched if the option is absent. Returns false if the value is missing.
+bool takeOption(std::vector<std::string>& args, const std::string& name, std::string& value) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == name) {
+            if (i + 1 >= args.size() || args[i + 1].rfind("--", 0) == 0) {
+                std::cout << "Missing value for " << name << "\n";
+                return false;
+            }
+            value = args[i + 1];
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            return true;
+        }
+    }
+    return true;
+}
+
 void showUsage() {
     std::cout << "echotwin - Lightweight Voice Cloning CLI\n\n";
     std::cout << "Usage:\n";
     std::cout << "  echotwin record [output.wav]        - Record 30 seconds from microphone\n";
     std::cout << "  echotwin featurize [input.wav]      - Extract features from audio\n";
+    std::cout << "      --config <name>                  Feature config (" << FeatureConfig::available() << ")\n";
+    std::cout << "      --precision <f32|f16|int8>       Storage precision for feature files\n";
+    std::cout << "      --cache-dir <dir>                Reuse features of previously seen audio\n";
     std::cout << "  echotwin train [mel] [f0] [voice]   - Train voice model\n";
+    std::cout << "      --precision <f32|f16|int8>       Storage precision for the voice model\n";
+    std::cout << "  echotwin clone [input.wav] [voice]  - Extract features and train in one pass\n";
+    std::cout << "      --dump-features <dir>            Also write the intermediate .npy files\n";
     std::cout << "  echotwin say <text> [voice] [out]   - Synthesize speech\n";
     std::cout << "  echotwin --export [voice] [text]    - Export WAV file\n";
+    std::cout << "      [out] may be a path, - (stdout) or fd:N; streamed output is not played\n";
+    std::cout << "      --format <wav|raw|flac|ogg>      Output encoding (default: from extension)\n";
+    std::cout << "  --seed <n>                          Seed noise for reproducible train/say/export output\n";
+    std::cout << "  --isa <generic|avx2|avx512>         Force a kernel build (default: best for this CPU)\n";
     std::cout << "  echotwin --version                   - Show version\n";
     std::cout << "  echotwin --help                     - Show this help\n";
 }
@@ -35,7 +67,70 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    std::string command = argv[1];
+    // Options may appear anywhere, including before the command, so they
+    // are all removed before the command is read.
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::string configName = FeatureConfig::defaults().name;
+    std::string precisionName = "f32";
+    std::string formatName = "auto";
+    std::string cacheDir, dumpDir, seedValue, isaName;
+    if (!takeOption(args, "--config", configName) ||
+        !takeOption(args, "--precision", precisionName) ||
+        !takeOption(args, "--format", formatName) ||
+        !takeOption(args, "--cache-dir", cacheDir) ||
+        !takeOption(args, "--dump-features", dumpDir) ||
+        !takeOption(args, "--seed", seedValue) ||
+        !takeOption(args, "--isa", isaName)) {
+        return 1;
+    }
+
+    if (args.empty()) {
+        showUsage();
+        return 1;
+    }
+    std::string command = args[0];
+
+    const FeatureConfig* featureConfig = FeatureConfig::find(configName);
+    if (!featureConfig) {
+        std::cout << "Unknown feature config: " << configName << " (available: "
+                  << FeatureConfig::available() << ")\n";
+        return 1;
+    }
+
+    Precision precision;
+    if (!Quantizer::parsePrecision(precisionName, precision)) {
+        std::cout << "Unknown precision: " << precisionName << " (available: f32, f16, int8)\n";
+        return 1;
+    }
+
+    OutputFormat outputFormat;
+    if (!AudioWriter::parseFormat(formatName, outputFormat)) {
+        std::cout << "Unknown output format: " << formatName << " (available: wav, raw, flac, ogg)\n";
+        return 1;
+    }
+
+    uint64_t seed = NoiseGenerator::randomSeed();
+    if (!seedValue.empty()) {
+        try {
+            seed = std::stoull(seedValue);
+        } catch (const std::exception&) {
+            std::cout << "Invalid seed: " << seedValue << "\n";
+            return 1;
+        }
+    }
+
+    if (!isaName.empty()) {
+        IsaLevel level;
+        if (!CpuDispatch::parseLevel(isaName, level)) {
+            std::cout << "Unknown ISA level: " << isaName << " (available: generic, avx2, avx512)\n";
+            return 1;
+        }
+        if (!CpuDispatch::select(level)) {
+            std::cout << "ISA level " << isaName << " is not supported by this CPU (best: "
+                      << CpuDispatch::levelName(CpuDispatch::detect()) << ")\n";
+            return 1;
+        }
+    }
 
     if (command == "--help" || command == "-h") {
         showUsage();
@@ -43,7 +138,8 @@ int main(int argc, char* argv[]) {
     }
 
     if (command == "--version" || command == "-v") {
-        std::cout << "echotwin version " << getVersion() << std::endl;
+        std::cout << "echotwin version " << getVersion() << " (kernels: "
+                  << CpuDispatch::levelName(CpuDispatch::active()) << ")" << std::endl;
         return 0;
     }
 
@@ -52,13 +148,18 @@ int main(int argc, char* argv[]) {
         std::string text = "Hello world";
         std::string outputFile = "export.wav";
         
-        if (argc >= 3) voiceModel = argv[2];
-        if (argc >= 4) text = argv[3];
-        if (argc >= 5) outputFile = argv[4];
+        if (args.size() >= 2) voiceModel = args[1];
+        if (args.size() >= 3) text = args[2];
+        if (args.size() >= 4) outputFile = args[3];
+        
+        // Streamed audio may share stdout (fd:1 as well as -), so keep logs off it.
+        if (AudioWriter::isStreamTarget(outputFile)) {
+            std::cout.rdbuf(std::cerr.rdbuf());
+        }
         
-        std::cout << "Exporting speech to WAV file..." << std::endl;
+        std::cout << "Exporting speech to audio file..." << std::endl;
         
-        if (SpeechSynthesizer::synthesize(text, voiceModel, outputFile)) {
+        if (SpeechSynthesizer::synthesize(text, voiceModel, outputFile, outputFormat, seed)) {
             std::cout << "Export completed: " << outputFile << std::endl;
             return 0;
         } else {
@@ -69,8 +170,8 @@ int main(int argc, char* argv[]) {
 
     if (command == "record") {
         std::string outputFile = "voice_sample.wav";
-        if (argc >= 3) {
-            outputFile = argv[2];
+        if (args.size() >= 2) {
+            outputFile = args[1];
         }
         
         if (AudioRecorder::record(outputFile)) {
@@ -82,15 +183,24 @@ int main(int argc, char* argv[]) {
         }
     } else if (command == "featurize") {
         std::string audioFile = "voice_sample.wav";
-        if (argc >= 3) {
-            audioFile = argv[2];
+        if (args.size() >= 2) {
+            audioFile = args[1];
         }
         
         std::cout << "Extracting features from: " << audioFile << std::endl;
         
+        std::unique_ptr<FeatureCache> cache;
+        if (!cacheDir.empty()) {
+            cache.reset(new FeatureCache(cacheDir));
+        }
+        
         bool success = true;
-        success &= FeatureExtractor::extractMelSpectrogram(audioFile, "mel_features.npy");
-        success &= FeatureExtractor::extractF0(audioFile, "f0_features.npy");
+        success &= FeatureExtractor::extractMelSpectrogram(audioFile, "mel_features.npy", *featureConfig, precision, cache.get());
+        success &= FeatureExtractor::extractF0(audioFile, "f0_features.npy", *featureConfig, precision, cache.get());
+        
+        if (cache) {
+            cache->reportStats();
+        }
         
         if (success) {
             std::cout << "Feature extraction completed successfully\n";
@@ -104,33 +214,81 @@ int main(int argc, char* argv[]) {
         std::string f0File = "f0_features.npy";
         std::string outputFile = "voice.vec";
         
-        if (argc >= 3) melFile = argv[2];
-        if (argc >= 4) f0File = argv[3];
-        if (argc >= 5) outputFile = argv[4];
+        if (args.size() >= 2) melFile = args[1];
+        if (args.size() >= 3) f0File = args[2];
+        if (args.size() >= 4) outputFile = args[3];
         
         std::cout << "Training voice encoder..." << std::endl;
         
-        if (VoiceTrainer::trainEncoder(melFile, f0File, outputFile)) {
+        if (VoiceTrainer::trainEncoder(melFile, f0File, outputFile, precision, seed)) {
             std::cout << "Training completed successfully\n";
             return 0;
         } else {
             std::cout << "Training failed\n";
             return 1;
         }
+    } else if (command == "clone") {
+        std::string audioFile = "voice_sample.wav";
+        std::string outputFile = "voice.vec";
+        
+        if (args.size() >= 2) audioFile = args[1];
+        if (args.size() >= 3) outputFile = args[2];
+        
+        std::cout << "Cloning voice from: " << audioFile << std::endl;
+        
+        std::unique_ptr<FeatureCache> cache;
+        if (!cacheDir.empty()) {
+            cache.reset(new FeatureCache(cacheDir));
+        }
+        
+        Eigen::MatrixXf melFeatures;
+        std::vector<float> f0Features;
+        bool success = FeatureExtractor::computeFeatures(audioFile, melFeatures, f0Features, *featureConfig, cache.get());
+        
+        if (cache) {
+            cache->reportStats();
+        }
+        
+        if (success && !dumpDir.empty()) {
+            std::filesystem::path dir(dumpDir);
+            std::error_code error;
+            std::filesystem::create_directories(dir, error);
+            if (error) {
+                std::cerr << "Failed to create directory " << dumpDir << ": " << error.message() << std::endl;
+                success = false;
+            }
+            success = success && FeatureExtractor::saveNpy(melFeatures, (dir / "mel_features.npy").string(), precision);
+            success = success && FeatureExtractor::saveNpy(f0Features, (dir / "f0_features.npy").string(), precision);
+        }
+        
+        success = success && VoiceTrainer::trainFromFeatures(melFeatures, f0Features, outputFile, precision, seed);
+        
+        if (success) {
+            std::cout << "Voice cloning completed successfully\n";
+            return 0;
+        } else {
+            std::cout << "Voice cloning failed\n";
+            return 1;
+        }
     } else if (command == "say") {
-        if (argc < 3) {
+        if (args.size() < 2) {
             std::cout << "Error: Please provide text to synthesize\n";
             return 1;
         }
         
-        std::string text = argv[2];
+        std::string text = args[1];
         std::string voiceModel = "voice.vec";
         std::string outputFile = "";
         
-        if (argc >= 4) voiceModel = argv[3];
-        if (argc >= 5) outputFile = argv[4];
+        if (args.size() >= 3) voiceModel = args[2];
+        if (args.size() >= 4) outputFile = args[3];
+        
+        // Streamed audio may share stdout (fd:1 as well as -), so keep logs off it.
+        if (AudioWriter::isStreamTarget(outputFile)) {
+            std::cout.rdbuf(std::cerr.rdbuf());
+        }
         
-        if (SpeechSynthesizer::synthesize(text, voiceModel, outputFile)) {
+        if (SpeechSynthesizer::synthesize(text, voiceModel, outputFile, outputFormat, seed)) {
             std::cout << "Speech synthesis completed successfully\n";
             return 0;
         } else {
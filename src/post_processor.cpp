@@ -0,0 +1,78 @@
+#include "post_processor.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+
+#define POST_BLOCK_SIZE 256
+#define DEEMPHASIS 0.7f
+#define TARGET_RMS 0.1f
+#define SILENCE_RMS 0.005f
+#define MIN_GAIN 0.1f
+#define MAX_GAIN 4.0f
+#define LOUDNESS_WINDOW 6400.0f
+#define LIMITER_THRESHOLD 0.8f
+
+PostProcessor::PostProcessor()
+    : firHistory{0.0f, 0.0f}, deemphasisState(0.0f), loudness(0.0f), gain(1.0f) {}
+
+void PostProcessor::process(float* audio, size_t count) {
+    for (size_t start = 0; start < count; start += POST_BLOCK_SIZE) {
+        processBlock(audio + start, std::min<size_t>(POST_BLOCK_SIZE, count - start));
+    }
+}
+
+void PostProcessor::processBlock(float* block, size_t count) {
+    alignas(32) float input[POST_BLOCK_SIZE + 2];
+
+    // Causal [0.25, 0.5, 0.25] FIR over the unsmoothed input. The two
+    // previous samples are carried over so blocks join seamlessly; the
+    // filter delays the signal by one sample.
+    input[0] = firHistory[0];
+    input[1] = firHistory[1];
+    std::copy(block, block + count, input + 2);
+    firHistory[0] = input[count];
+    firHistory[1] = input[count + 1];
+
+    for (size_t i = 0; i < count; ++i) {
+        block[i] = 0.25f * input[i] + 0.5f * input[i + 1] + 0.25f * input[i + 2];
+    }
+
+    // De-emphasis is a one-pole IIR and inherently serial; it is a single
+    // multiply-add per sample while the block is still in cache.
+    float state = deemphasisState;
+    for (size_t i = 0; i < count; ++i) {
+        state = block[i] + DEEMPHASIS * state;
+        block[i] = state;
+    }
+    deemphasisState = state;
+
+    // Loudness: track mean-square energy over a ~400 ms window, ignoring
+    // silent blocks, and ramp the gain across the block to avoid zipper noise.
+    float meanSquare = Eigen::Map<const Eigen::ArrayXf>(block, count).square().mean();
+    if (meanSquare > SILENCE_RMS * SILENCE_RMS) {
+        float weight = float(count) / LOUDNESS_WINDOW;
+        loudness = loudness > 0.0f ? loudness + (meanSquare - loudness) * weight : meanSquare;
+    }
+
+    float startGain = gain;
+    if (loudness > 0.0f) {
+        gain = std::max(MIN_GAIN, std::min(MAX_GAIN, TARGET_RMS / std::sqrt(loudness)));
+    }
+    float step = (gain - startGain) / count;
+
+    // Soft limiter: linear below the threshold, then a smooth u / (1 + u)
+    // knee that approaches full scale without ever clipping. The clamp is
+    // written as max(0, d) = (d + |d|) / 2, which is exact, so the loop has
+    // no selects and vectorizes without relaxing floating-point semantics.
+    const float headroom = 1.0f - LIMITER_THRESHOLD;
+    const int n = int(count);
+    for (int i = 0; i < n; ++i) {
+        float x = block[i] * (startGain + step * float(i));
+        float magnitude = std::fabs(x);
+        float distance = magnitude - LIMITER_THRESHOLD;
+        float excess = 0.5f * (distance + std::fabs(distance));
+        float over = excess / headroom;
+        float limited = (magnitude - excess) + headroom * over / (1.0f + over);
+        block[i] = std::copysign(limited, x);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+
+// Streaming post-processing chain for synthesized audio: 3-tap FIR smoothing,
+// de-emphasis, loudness normalization and a soft limiter. Audio is processed
+// in place in fixed-size blocks with all filter state carried across calls,
+// so it can run on each chunk as it is produced instead of as extra passes
+// over a finished buffer.
+class PostProcessor {
+public:
+    PostProcessor();
+
+    void process(float* audio, size_t count);
+
+private:
+    void processBlock(float* block, size_t count);
+
+    float firHistory[2];
+    float deemphasisState;
+    float loudness;
+    float gain;
+};
\ No newline at end of file
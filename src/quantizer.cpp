@@ -0,0 +1,89 @@
+#include "quantizer.h"
+#include "cpu_dispatch.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+bool Quantizer::parsePrecision(const std::string& name, Precision& precision) {
+    if (name == "f32" || name == "float32") {
+        precision = Precision::Float32;
+    } else if (name == "f16" || name == "float16") {
+        precision = Precision::Float16;
+    } else if (name == "int8") {
+        precision = Precision::Int8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Quantizer::precisionName(Precision precision) {
+    switch (precision) {
+        case Precision::Float16: return "f16";
+        case Precision::Int8: return "int8";
+        default: return "f32";
+    }
+}
+
+// int8 rows are stored as records of the quantized values plus their scale,
+// so a plain .npy reader sees a structured array instead of raw integers it
+// could mistake for the features themselves.
+std::string Quantizer::npyDescr(Precision precision, size_t cols) {
+    switch (precision) {
+        case Precision::Float16: return "'<f2'";
+        case Precision::Int8: return "[('q', '|i1', (" + std::to_string(cols) + ",)), ('scale', '<f4')]";
+        default: return "'<f4'";
+    }
+}
+
+void Quantizer::toHalf(const float* input, uint16_t* output, size_t count) {
+    CpuDispatch::kernels().toHalf(input, output, count);
+}
+
+void Quantizer::fromHalf(const uint16_t* input, float* output, size_t count) {
+    CpuDispatch::kernels().fromHalf(input, output, count);
+}
+
+float Quantizer::toInt8(const float* input, int8_t* output, size_t count) {
+    float maxAbs = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        maxAbs = std::max(maxAbs, std::fabs(input[i]));
+    }
+
+    float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+    float inverse = 1.0f / scale;
+    for (size_t i = 0; i < count; ++i) {
+        float q = std::nearbyint(input[i] * inverse);
+        output[i] = int8_t(std::max(-127.0f, std::min(127.0f, q)));
+    }
+
+    return scale;
+}
+
+void Quantizer::fromInt8(const int8_t* input, float scale, float* output, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        output[i] = float(input[i]) * scale;
+    }
+}
+
+void Quantizer::reportError(const std::string& label, Precision precision,
+                            const float* original, const float* restored, size_t count) {
+    double maxError = 0.0;
+    double errorEnergy = 0.0;
+    double signalEnergy = 0.0;
+
+    for (size_t i = 0; i < count; ++i) {
+        double diff = double(original[i]) - restored[i];
+        maxError = std::max(maxError, std::fabs(diff));
+        errorEnergy += diff * diff;
+        signalEnergy += double(original[i]) * original[i];
+    }
+
+    double rms = count > 0 ? std::sqrt(errorEnergy / count) : 0.0;
+    std::cout << precisionName(precision) << " round-trip error (" << label << "): max " << maxError
+              << ", rms " << rms;
+    if (errorEnergy > 0.0 && signalEnergy > 0.0) {
+        std::cout << ", SNR " << 10.0 * std::log10(signalEnergy / errorEnergy) << " dB";
+    }
+    std::cout << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Voice models written with a non-float32 precision start with this tag so
+// the loader can tell them apart from the legacy "uint32 size + floats" layout.
+#define VOICE_MODEL_MAGIC 0x43455645u  // "EVEC"
+
+enum class Precision : uint32_t {
+    Float32 = 0,
+    Float16 = 1,
+    Int8 = 2
+};
+
+class Quantizer {
+public:
+    static bool parsePrecision(const std::string& name, Precision& precision);
+    static const char* precisionName(Precision precision);
+    // Python literal for the .npy 'descr' field of a file with cols values per row.
+    static std::string npyDescr(Precision precision, size_t cols);
+
+    static void toHalf(const float* input, uint16_t* output, size_t count);
+    static void fromHalf(const uint16_t* input, float* output, size_t count);
+
+    // Symmetric int8 quantization of one row; returns the scale to store.
+    static float toInt8(const float* input, int8_t* output, size_t count);
+    static void fromInt8(const int8_t* input, float scale, float* output, size_t count);
+
+    static void reportError(const std::string& label, Precision precision,
+                            const float* original, const float* restored, size_t count);
+};
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "resampler.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#define ZERO_CROSSINGS 16
+#define KAISER_BETA 8.0
+#define ROLLOFF 0.95
+
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+Resampler::Resampler(int inputRate, int outputRate)
+    : historyStart(0), nextTime(0), received(0), produced(0) {
+    int divisor = std::gcd(inputRate, outputRate);
+    upFactor = outputRate / divisor;
+    downFactor = inputRate / divisor;
+
+    if (upFactor == 1 && downFactor == 1) {
+        tapsPerPhase = 1;
+        delay = 0;
+        coefficients = {1.0f};
+        return;
+    }
+
+    // Widen the filter when decimating so the lower cutoff keeps the same
+    // transition band measured in input samples.
+    double ratio = std::max(1.0, double(downFactor) / upFactor);
+    tapsPerPhase = 2 * int(std::ceil(ZERO_CROSSINGS * ratio));
+
+    const int length = upFactor * tapsPerPhase;
+    delay = length / 2;
+    const double cutoff = ROLLOFF * 0.5 / std::max(upFactor, downFactor);
+    const double normalizer = besselI0(KAISER_BETA);
+
+    // Prototype low-pass at the upsampled rate, split into one reversed
+    // sub-filter per phase so each output is a contiguous dot product.
+    coefficients.assign(length, 0.0f);
+    for (int n = 0; n < length; ++n) {
+        double x = double(n - delay);
+        double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * M_PI * cutoff * x) / (2.0 * M_PI * cutoff * x);
+        double position = x / (length / 2.0);
+        double window = besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - position * position))) / normalizer;
+
+        int phase = n % upFactor;
+        int tap = n / upFactor;
+        coefficients[phase * tapsPerPhase + (tapsPerPhase - 1 - tap)] =
+            float(2.0 * cutoff * sinc * window * upFactor);
+    }
+
+    nextTime = delay;
+    historyStart = -(tapsPerPhase - 1);
+    history.assign(tapsPerPhase - 1, 0.0f);
+}
+
+size_t Resampler::expectedOutput(size_t inputFrames) const {
+    return (uint64_t(inputFrames) * upFactor + downFactor - 1) / downFactor;
+}
+
+void Resampler::process(const float* input, size_t count, std::vector<float>& output) {
+    received += count;
+
+    if (upFactor == 1 && downFactor == 1) {
+        output.insert(output.end(), input, input + count);
+        produced += count;
+        return;
+    }
+
+    history.insert(history.end(), input, input + count);
+    emitAvailable(output);
+}
+
+void Resampler::flush(std::vector<float>& output) {
+    if (upFactor == 1 && downFactor == 1) {
+        return;
+    }
+
+    const uint64_t target = expectedOutput(received);
+    history.insert(history.end(), delay / upFactor + tapsPerPhase + 1, 0.0f);
+    emitAvailable(output);
+
+    if (produced > target) {
+        output.resize(output.size() - (produced - target));
+        produced = target;
+    }
+}
+
+void Resampler::emitAvailable(std::vector<float>& output) {
+    const int64_t lastIndex = historyStart + int64_t(history.size()) - 1;
+    const int64_t available = nextTime / upFactor <= lastIndex
+        ? (lastIndex * upFactor + upFactor - 1 - nextTime) / downFactor + 1
+        : 0;
+
+    size_t writePos = output.size();
+    output.resize(writePos + available);
+
+    for (int64_t i = 0; i < available; ++i) {
+        const int64_t base = nextTime / upFactor;
+        const int phase = int(nextTime % upFactor);
+
+        Eigen::Map<const Eigen::VectorXf> taps(&coefficients[size_t(phase) * tapsPerPhase], tapsPerPhase);
+        Eigen::Map<const Eigen::VectorXf> samples(&history[base - tapsPerPhase + 1 - historyStart], tapsPerPhase);
+        output[writePos++] = taps.dot(samples);
+
+        nextTime += downFactor;
+    }
+    produced += available;
+
+    const int64_t keepFrom = nextTime / upFactor - tapsPerPhase + 1;
+    if (keepFrom > historyStart) {
+        size_t drop = std::min<size_t>(keepFrom - historyStart, history.size());
+        history.erase(history.begin(), history.begin() + drop);
+        historyStart += drop;
+    }
+}
+
+void Resampler::downmix(const float* interleaved, size_t frames, int channels, float* mono) {
+    if (channels == 1) {
+        std::copy(interleaved, interleaved + frames, mono);
+        return;
+    }
+
+    if (channels == 2) {
+        for (size_t i = 0; i < frames; ++i) {
+            mono[i] = 0.5f * (interleaved[2 * i] + interleaved[2 * i + 1]);
+        }
+        return;
+    }
+
+    Eigen::Map<const Eigen::MatrixXf> samples(interleaved, channels, frames);
+    Eigen::Map<Eigen::RowVectorXf>(mono, frames) = samples.colwise().mean();
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Streaming rational-ratio polyphase resampler. Input is fed in arbitrary
+// chunks as it is decoded; output samples are appended as soon as enough
+// history is available, so the full input never has to be buffered.
+class Resampler {
+public:
+    Resampler(int inputRate, int outputRate);
+
+    void process(const float* input, size_t count, std::vector<float>& output);
+    void flush(std::vector<float>& output);
+
+    size_t expectedOutput(size_t inputFrames) const;
+
+    static void downmix(const float* interleaved, size_t frames, int channels, float* mono);
+
+private:
+    void emitAvailable(std::vector<float>& output);
+
+    int upFactor;
+    int downFactor;
+    int tapsPerPhase;
+    int64_t delay;
+
+    std::vector<float> coefficients;
+    std::vector<float> history;
+    int64_t historyStart;
+    int64_t nextTime;
+    uint64_t received;
+    uint64_t produced;
+};
\ No newline at end of file
@@ -1,17 +1,31 @@
 #include "speech_synthesizer.h"
+#include "feature_config.h"
+#include "quantizer.h"
+#include "post_processor.h"
+#include "audio_writer.h"
+#include "noise_generator.h"
+#include "cpu_dispatch.h"
 #include <portaudio.h>
 #include <sndfile.h>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <cmath>
-#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
-#define SAMPLE_RATE 16000
+#define SAMPLES_PER_TOKEN (SAMPLE_RATE / 10)
+#define MIN_SEGMENT_TOKENS 8
+#define MAX_SEGMENT_TOKENS 40
+#define CROSSFADE_SAMPLES (SAMPLE_RATE / 100)
+#define SEGMENTS_AHEAD_PER_THREAD 2
 
 bool SpeechSynthesizer::synthesize(const std::string& text, 
                                   const std::string& voiceModelPath,
-                                  const std::string& outputPath) {
+                                  const std::string& outputPath,
+                                  OutputFormat format,
+                                  uint64_t seed) {
     
     std::cout << "Loading voice model: " << voiceModelPath << std::endl;
     std::vector<float> voiceEmbedding = loadVoiceEmbedding(voiceModelPath);
@@ -24,20 +38,42 @@ bool SpeechSynthesizer::synthesize(const std::string& text,
     std::cout << "Converting text to tokens..." << std::endl;
     std::vector<int> tokens = textToTokens(text);
     
+    AudioWriter writer;
+    bool writeOk = true;
+    if (!outputPath.empty()) {
+        std::cout << "Saving to: " << outputPath << std::endl;
+        if (!writer.open(outputPath, format, SAMPLE_RATE)) {
+            std::cerr << "Failed to open audio output" << std::endl;
+            return false;
+        }
+    }
+    
+    // Streamed output is never played, so only keep the audio when it will be.
+    const bool play = !AudioWriter::isStreamTarget(outputPath);
+    std::vector<float> audio;
+    
     std::cout << "Generating speech for: \"" << text << "\"" << std::endl;
-    std::vector<float> audio = generateSpeech(tokens, voiceEmbedding);
+    size_t generated = generateSpeech(tokens, voiceEmbedding, seed, [&](const float* block, size_t count) {
+        if (!outputPath.empty() && writeOk) {
+            writeOk = writer.write(block, count);
+        }
+        if (play) {
+            audio.insert(audio.end(), block, block + count);
+        }
+    });
     
-    if (audio.empty()) {
+    if (generated == 0) {
         std::cerr << "Failed to generate speech" << std::endl;
         return false;
     }
     
-    if (!outputPath.empty()) {
-        std::cout << "Saving to: " << outputPath << std::endl;
-        if (!saveWav(audio, outputPath, SAMPLE_RATE)) {
-            std::cerr << "Failed to save audio file" << std::endl;
-            return false;
-        }
+    if (!outputPath.empty() && !(writer.close() && writeOk)) {
+        std::cerr << "Failed to save audio file" << std::endl;
+        return false;
+    }
+    
+    if (!play) {
+        return true;
     }
     
     std::cout << "Playing synthesized speech..." << std::endl;
@@ -54,12 +90,39 @@ std::vector<float> SpeechSynthesizer::loadVoiceEmbedding(const std::string& path
     uint32_t size;
     file.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
     
+    Precision precision = Precision::Float32;
+    if (size == VOICE_MODEL_MAGIC) {
+        uint32_t format;
+        file.read(reinterpret_cast<char*>(&format), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+        precision = Precision(format);
+    }
+    
     std::vector<float> embedding(size);
-    for (uint32_t i = 0; i < size; ++i) {
-        file.read(reinterpret_cast<char*>(&embedding[i]), sizeof(float));
+    if (precision == Precision::Float32) {
+        file.read(reinterpret_cast<char*>(embedding.data()), size * sizeof(float));
+    } else if (precision == Precision::Float16) {
+        std::vector<uint16_t> half(size);
+        file.read(reinterpret_cast<char*>(half.data()), size * sizeof(uint16_t));
+        Quantizer::fromHalf(half.data(), embedding.data(), size);
+    } else if (precision == Precision::Int8) {
+        float scale;
+        std::vector<int8_t> quantized(size);
+        file.read(reinterpret_cast<char*>(&scale), sizeof(float));
+        file.read(reinterpret_cast<char*>(quantized.data()), size);
+        Quantizer::fromInt8(quantized.data(), scale, embedding.data(), size);
+    } else {
+        std::cerr << "Unsupported voice model format: " << uint32_t(precision) << std::endl;
+        return {};
+    }
+    
+    if (!file) {
+        std::cerr << "Truncated voice model: " << path << std::endl;
+        return {};
     }
     
-    std::cout << "Loaded voice embedding: " << size << " dimensions" << std::endl;
+    std::cout << "Loaded voice embedding: " << size << " dimensions ("
+              << Quantizer::precisionName(precision) << ")" << std::endl;
     return embedding;
 }
 
@@ -89,21 +152,43 @@ std::vector<int> SpeechSynthesizer::textToTokens(const std::string& text) {
     return tokens;
 }
 
-std::vector<float> SpeechSynthesizer::generateSpeech(const std::vector<int>& tokens, 
-                                                   const std::vector<float>& voiceEmbedding) {
+std::vector<std::pair<size_t, size_t>> SpeechSynthesizer::splitSegments(const std::vector<int>& tokens) {
+    std::vector<std::pair<size_t, size_t>> segments;
+    size_t start = 0;
+    
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        // Break after punctuation, or at the next space once a run without
+        // punctuation gets long, so one segment never holds a whole document.
+        const size_t length = i + 1 - start;
+        bool punctuation = tokens[i] >= 28 && tokens[i] <= 31;
+        bool longRun = tokens[i] == 27 && length >= MAX_SEGMENT_TOKENS;
+        if ((punctuation && length >= MIN_SEGMENT_TOKENS) || longRun) {
+            segments.emplace_back(start, i + 1);
+            start = i + 1;
+        }
+    }
     
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::normal_distribution<float> noise(0.0f, 0.1f);
+    if (start < tokens.size()) {
+        segments.emplace_back(start, tokens.size());
+    }
     
-    const int samplesPerToken = SAMPLE_RATE / 10;
-    const int totalSamples = tokens.size() * samplesPerToken;
+    return segments;
+}
+
+void SpeechSynthesizer::renderSegment(const std::vector<int>& tokens, 
+                                      size_t begin, size_t end,
+                                      const std::vector<float>& voiceEmbedding,
+                                      NoiseGenerator noise,
+                                      float* output,
+                                      const std::function<void(size_t)>& progress) {
     
-    std::vector<float> audio(totalSamples);
+    const int samplesPerToken = SAMPLES_PER_TOKEN;
+    std::vector<float> noiseBlock(samplesPerToken);
+    const KernelTable& kernels = CpuDispatch::kernels();
     
-    for (size_t i = 0; i < tokens.size(); ++i) {
+    for (size_t i = begin; i < end; ++i) {
         int token = tokens[i];
-        int startSample = i * samplesPerToken;
+        int startSample = (i - begin) * samplesPerToken;
         
         float baseFreq = 100.0f + token * 10.0f;
         
@@ -114,57 +199,159 @@ std::vector<float> SpeechSynthesizer::generateSpeech(const std::vector<int>& tok
         
         baseFreq = std::max(50.0f, std::min(500.0f, baseFreq));
         
-        for (int j = 0; j < samplesPerToken; ++j) {
-            if (startSample + j < audio.size()) {
-                float t = float(j) / SAMPLE_RATE;
-                
-                float amp = 0.3f;
-                if (token == 27) {
-                    amp = 0.05f;
-                } else if (token == 28 || token == 29) {
-                    amp = 0.1f;
-                }
-                
-                float fadeIn = std::min(1.0f, float(j) / (samplesPerToken * 0.1f));
-                float fadeOut = std::min(1.0f, float(samplesPerToken - j) / (samplesPerToken * 0.1f));
-                amp *= fadeIn * fadeOut;
-                
-                float sample = amp * std::sin(2.0f * M_PI * baseFreq * t);
-                sample += amp * 0.3f * std::sin(2.0f * M_PI * baseFreq * 2.0f * t);
-                sample += amp * 0.1f * std::sin(2.0f * M_PI * baseFreq * 3.0f * t);
-                
-                sample += noise(gen) * 0.02f;
-                
-                audio[startSample + j] = std::max(-1.0f, std::min(1.0f, sample));
+        noise.fillGaussian(noiseBlock.data(), samplesPerToken, 0.1f);
+        
+        float amp = 0.3f;
+        if (token == 27) {
+            amp = 0.05f;
+        } else if (token == 28 || token == 29) {
+            amp = 0.1f;
+        }
+        
+        kernels.renderTone(output + startSample, samplesPerToken, baseFreq / SAMPLE_RATE, amp,
+                           noiseBlock.data(), 0.02f);
+        progress(startSample + samplesPerToken);
+    }
+}
+
+// Renders sentence/clause segments on worker threads and stitches them in
+// order on the calling thread. Segment k draws noise from stream k of the
+// seed, so output does not depend on thread scheduling. Workers publish
+// every finished token, and the calling thread crossfades, post-processes
+// and hands those blocks to the sink as soon as everything before them is
+// out, so the first audio leaves after one token of work even while the
+// rest of the document is still rendering. Workers stay at most
+// SEGMENTS_AHEAD_PER_THREAD segments per thread ahead of the one being
+// emitted, and a segment's buffer only exists from when it is claimed until
+// it has been emitted, so memory does not grow with the length of the text.
+// Returns the number of samples handed to the sink.
+size_t SpeechSynthesizer::generateSpeech(const std::vector<int>& tokens, 
+                                         const std::vector<float>& voiceEmbedding,
+                                         uint64_t seed,
+                                         const BlockSink& sink) {
+    
+    const NoiseGenerator noise(seed);
+    const std::vector<std::pair<size_t, size_t>> segments = splitSegments(tokens);
+    const size_t numSegments = segments.size();
+    
+    size_t numThreads = std::min<size_t>(numSegments, std::max(1u, std::thread::hardware_concurrency()));
+    const size_t maxAhead = numThreads * SEGMENTS_AHEAD_PER_THREAD;
+    
+    // Everything below except the contents of claimed buffers is guarded by
+    // mutex. A buffer is allocated when its segment is claimed and freed once
+    // it has been emitted; the calling thread only touches it after the
+    // worker has published its first token.
+    std::vector<std::vector<float>> rendered(numSegments);
+    std::vector<size_t> readySamples(numSegments, 0);
+    size_t nextSegment = 0;
+    size_t currentSegment = 0;
+    std::mutex mutex;
+    std::condition_variable segmentReady;
+    
+    auto worker = [&]() {
+        for (;;) {
+            size_t k;
+            float* output;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                segmentReady.wait(lock, [&]() {
+                    return nextSegment >= numSegments || nextSegment < currentSegment + maxAhead;
+                });
+                if (nextSegment >= numSegments) return;
+                k = nextSegment++;
+                rendered[k].resize((segments[k].second - segments[k].first) * SAMPLES_PER_TOKEN);
+                output = rendered[k].data();
             }
+            renderSegment(tokens, segments[k].first, segments[k].second, voiceEmbedding, noise.split(k),
+                          output, [&, k](size_t samples) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    readySamples[k] = samples;
+                }
+                segmentReady.notify_all();
+            });
         }
+    };
+    
+    if (numSegments > 1) {
+        std::cout << "Rendering " << numSegments << " segments on " << numThreads << " threads" << std::endl;
     }
     
-    for (int i = 1; i < audio.size() - 1; ++i) {
-        audio[i] = 0.25f * audio[i-1] + 0.5f * audio[i] + 0.25f * audio[i+1];
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < numThreads; ++i) {
+        workers.emplace_back(worker);
     }
     
-    return audio;
-}
-
-bool SpeechSynthesizer::saveWav(const std::vector<float>& audio, 
-                               const std::string& path, 
-                               int sampleRate) {
-    SF_INFO info;
-    info.samplerate = sampleRate;
-    info.channels = 1;
-    info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
-    
-    SNDFILE* file = sf_open(path.c_str(), SFM_WRITE, &info);
-    if (!file) {
-        std::cerr << "Failed to create output file: " << sf_strerror(nullptr) << std::endl;
-        return false;
+    size_t generated = 0;
+    PostProcessor postProcessor;
+    
+    auto emit = [&](float* block, size_t count) {
+        postProcessor.process(block, count);
+        generated += count;
+        if (sink) {
+            sink(block, count);
+        }
+    };
+    
+    auto waitFor = [&](size_t k, size_t samples) {
+        std::unique_lock<std::mutex> lock(mutex);
+        segmentReady.wait(lock, [&]() { return readySamples[k] >= samples; });
+    };
+    
+    std::vector<float> tail;
+    for (size_t k = 0; k < numSegments; ++k) {
+        const size_t length = (segments[k].second - segments[k].first) * SAMPLES_PER_TOKEN;
+        const size_t overlap = std::min(tail.size(), length);
+        
+        // Hold back the end of every segment but the last so it can be
+        // blended with the start of the next one.
+        size_t keep = length;
+        if (k + 1 < numSegments) {
+            keep -= std::min<size_t>(CROSSFADE_SAMPLES, length);
+        }
+        
+        waitFor(k, std::min<size_t>(SAMPLES_PER_TOKEN, length));
+        float* segment = rendered[k].data();
+        
+        // Blend the start of this segment with the held-back end of the
+        // previous one, one newly finished range at a time.
+        auto crossfade = [&](size_t from, size_t to) {
+            for (size_t i = from; i < std::min(to, overlap); ++i) {
+                float weight = (i + 0.5f) / overlap;
+                segment[i] = tail[i] * (1.0f - weight) + segment[i] * weight;
+            }
+        };
+        
+        // Step one token at a time however far the worker has got, so block
+        // boundaries, and with them the post-processed output, never depend
+        // on thread timing.
+        for (size_t emitted = 0; emitted < keep; ) {
+            size_t next = std::min<size_t>(emitted + SAMPLES_PER_TOKEN, keep);
+            waitFor(k, next);
+            crossfade(emitted, next);
+            emit(segment + emitted, next - emitted);
+            emitted = next;
+        }
+        
+        waitFor(k, length);
+        crossfade(keep, length);
+        tail.assign(segment + keep, segment + length);
+        
+        // The worker is done with segment k; free it and let the next
+        // segment in the window be claimed.
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<float>().swap(rendered[k]);
+            ++currentSegment;
+        }
+        segmentReady.notify_all();
     }
     
-    sf_write_float(file, audio.data(), audio.size());
-    sf_close(file);
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
     
-    return true;
+    return generated;
 }
 
 bool SpeechSynthesizer::playAudio(const std::vector<float>& audio, int sampleRate) {
@@ -1,21 +1,38 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <functional>
+#include <utility>
+#include "audio_writer.h"
+#include "noise_generator.h"
 
 class SpeechSynthesizer {
 public:
+    // Receives each block of finished audio as soon as it is synthesized.
+    typedef std::function<void(const float*, size_t)> BlockSink;
+    
     static bool synthesize(const std::string& text, 
                           const std::string& voiceModelPath,
-                          const std::string& outputPath = "");
+                          const std::string& outputPath = "",
+                          OutputFormat format = OutputFormat::Auto,
+                          uint64_t seed = NoiseGenerator::randomSeed());
     
     static bool playAudio(const std::vector<float>& audio, int sampleRate);
     
 private:
     static std::vector<float> loadVoiceEmbedding(const std::string& path);
     static std::vector<int> textToTokens(const std::string& text);
-    static std::vector<float> generateSpeech(const std::vector<int>& tokens, 
-                                           const std::vector<float>& voiceEmbedding);
-    static bool saveWav(const std::vector<float>& audio, 
-                       const std::string& path, 
-                       int sampleRate);
+    static std::vector<std::pair<size_t, size_t>> splitSegments(const std::vector<int>& tokens);
+    // Renders tokens [begin, end) into output, reporting the number of
+    // finished samples after every token.
+    static void renderSegment(const std::vector<int>& tokens, 
+                              size_t begin, size_t end,
+                              const std::vector<float>& voiceEmbedding,
+                              NoiseGenerator noise,
+                              float* output,
+                              const std::function<void(size_t)>& progress);
+    static size_t generateSpeech(const std::vector<int>& tokens, 
+                                 const std::vector<float>& voiceEmbedding,
+                                 uint64_t seed,
+                                 const BlockSink& sink = nullptr);
 };
\ No newline at end of file
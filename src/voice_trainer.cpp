@@ -1,12 +1,16 @@
 #include "voice_trainer.h"
+#include "quantizer.h"
+#include "noise_generator.h"
+#include "cpu_dispatch.h"
 #include <iostream>
 #include <fstream>
-#include <random>
 #include <cmath>
 
 bool VoiceTrainer::trainEncoder(const std::string& melFeaturesPath, 
                                const std::string& f0FeaturesPath,
-                               const std::string& outputModelPath) {
+                               const std::string& outputModelPath,
+                               Precision precision,
+                               uint64_t seed) {
     
     std::cout << "Loading features..." << std::endl;
     
@@ -18,43 +22,120 @@ bool VoiceTrainer::trainEncoder(const std::string& melFeaturesPath,
         return false;
     }
     
+    return trainFromFeatures(melFeatures, f0Features, outputModelPath, precision, seed);
+}
+
+bool VoiceTrainer::trainFromFeatures(const Eigen::MatrixXf& melFeatures, 
+                                    const std::vector<float>& f0Features,
+                                    const std::string& outputModelPath,
+                                    Precision precision,
+                                    uint64_t seed) {
+    
     std::cout << "Mel features: " << melFeatures.rows() << " x " << melFeatures.cols() << std::endl;
     std::cout << "F0 features: " << f0Features.size() << " frames" << std::endl;
     
-    return runTrainingLoop(melFeatures, f0Features, outputModelPath);
+    return runTrainingLoop(melFeatures, f0Features, outputModelPath, precision, seed);
 }
 
-Eigen::MatrixXf VoiceTrainer::loadNpyMatrix(const std::string& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file) {
-        std::cerr << "Failed to open: " << path << std::endl;
-        return Eigen::MatrixXf();
-    }
-
-    char header[10];
-    file.read(header, 10);
+// Reads the .npy preamble and returns the dtype descriptor and shape. A
+// one-dimensional array is reported as a single row. int8 files written by
+// FeatureExtractor are a 1-D array of (q, scale) records; they are reported
+// as "int8-rows" with one row per record.
+static bool readNpyHeader(std::ifstream& file, std::string& descr, size_t& rows, size_t& cols) {
+    char magic[8];
+    file.read(magic, 8);
     
     uint16_t header_len;
     file.read(reinterpret_cast<char*>(&header_len), 2);
+    if (!file || std::string(magic + 1, 5) != "NUMPY") {
+        return false;
+    }
     
     std::string dtype_info(header_len, ' ');
     file.read(&dtype_info[0], header_len);
     
-    size_t shape_start = dtype_info.find("shape': (") + 9;
-    size_t comma_pos = dtype_info.find(", ", shape_start);
-    size_t end_pos = dtype_info.find(")", comma_pos);
+    const std::string recordField = "('q', '|i1', (";
+    size_t record_start = dtype_info.find("descr': [");
+    size_t recordCols = 0;
+    if (record_start != std::string::npos) {
+        size_t field_start = dtype_info.find(recordField, record_start);
+        if (field_start == std::string::npos || dtype_info.find("('scale', '<f4')", field_start) == std::string::npos) {
+            return false;
+        }
+        descr = "int8-rows";
+        recordCols = std::stoul(dtype_info.substr(field_start + recordField.size()));
+    } else {
+        size_t descr_start = dtype_info.find("descr': '") + 9;
+        descr = dtype_info.substr(descr_start, dtype_info.find("'", descr_start) - descr_start);
+    }
     
-    int rows = std::stoi(dtype_info.substr(shape_start, comma_pos - shape_start));
-    int cols = std::stoi(dtype_info.substr(comma_pos + 2, end_pos - comma_pos - 2));
+    size_t shape_start = dtype_info.find("shape': (") + 9;
+    size_t end_pos = dtype_info.find(")", shape_start);
+    std::string shape = dtype_info.substr(shape_start, end_pos - shape_start);
+    size_t comma_pos = shape.find(",");
+    
+    std::string second = shape.substr(comma_pos + 1);
+    if (second.find_first_of("0123456789") == std::string::npos) {
+        rows = 1;
+        cols = std::stoul(shape.substr(0, comma_pos));
+    } else {
+        rows = std::stoul(shape.substr(0, comma_pos));
+        cols = std::stoul(second);
+    }
     
-    Eigen::MatrixXf matrix(rows, cols);
+    if (descr == "int8-rows") {
+        rows = cols;
+        cols = recordCols;
+    }
     
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            float val;
-            file.read(reinterpret_cast<char*>(&val), sizeof(float));
-            matrix(i, j) = val;
+    return bool(file);
+}
+
+// Reads rows x cols values in row-major order, dequantizing f16 and
+// per-row-scaled int8 data into float32.
+static bool readNpyData(std::ifstream& file, const std::string& descr, size_t rows, size_t cols, float* output) {
+    const size_t count = rows * cols;
+    
+    if (descr == "<f4") {
+        file.read(reinterpret_cast<char*>(output), count * sizeof(float));
+    } else if (descr == "<f2") {
+        std::vector<uint16_t> half(count);
+        file.read(reinterpret_cast<char*>(half.data()), count * sizeof(uint16_t));
+        Quantizer::fromHalf(half.data(), output, count);
+    } else if (descr == "int8-rows") {
+        std::vector<int8_t> quantized(cols);
+        for (size_t row = 0; row < rows; ++row) {
+            float scale;
+            file.read(reinterpret_cast<char*>(quantized.data()), cols);
+            file.read(reinterpret_cast<char*>(&scale), sizeof(float));
+            Quantizer::fromInt8(quantized.data(), scale, output + row * cols, cols);
         }
+    } else {
+        std::cerr << "Unsupported .npy dtype: " << descr << std::endl;
+        return false;
+    }
+    
+    return bool(file);
+}
+
+Eigen::MatrixXf VoiceTrainer::loadNpyMatrix(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open: " << path << std::endl;
+        return Eigen::MatrixXf();
+    }
+
+    std::string descr;
+    size_t rows, cols;
+    if (!readNpyHeader(file, descr, rows, cols)) {
+        std::cerr << "Invalid .npy file: " << path << std::endl;
+        return Eigen::MatrixXf();
+    }
+    
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> matrix(rows, cols);
+    if (!readNpyData(file, descr, rows, cols, matrix.data())) {
+        std::cerr << "Failed to read: " << path << std::endl;
+        return Eigen::MatrixXf();
     }
     
     return matrix;
@@ -67,23 +148,17 @@ std::vector<float> VoiceTrainer::loadNpyVector(const std::string& path) {
         return {};
     }
 
-    char header[10];
-    file.read(header, 10);
-    
-    uint16_t header_len;
-    file.read(reinterpret_cast<char*>(&header_len), 2);
-    
-    std::string dtype_info(header_len, ' ');
-    file.read(&dtype_info[0], header_len);
-    
-    size_t shape_start = dtype_info.find("shape': (") + 9;
-    size_t end_pos = dtype_info.find(",)", shape_start);
-    
-    int size = std::stoi(dtype_info.substr(shape_start, end_pos - shape_start));
+    std::string descr;
+    size_t rows, cols;
+    if (!readNpyHeader(file, descr, rows, cols)) {
+        std::cerr << "Invalid .npy file: " << path << std::endl;
+        return {};
+    }
     
-    std::vector<float> vector(size);
-    for (int i = 0; i < size; ++i) {
-        file.read(reinterpret_cast<char*>(&vector[i]), sizeof(float));
+    std::vector<float> vector(rows * cols);
+    if (!readNpyData(file, descr, rows, cols, vector.data())) {
+        std::cerr << "Failed to read: " << path << std::endl;
+        return {};
     }
     
     return vector;
@@ -91,7 +166,9 @@ std::vector<float> VoiceTrainer::loadNpyVector(const std::string& path) {
 
 bool VoiceTrainer::runTrainingLoop(const Eigen::MatrixXf& melFeatures, 
                                   const std::vector<float>& f0Features,
-                                  const std::string& outputPath) {
+                                  const std::string& outputPath,
+                                  Precision precision,
+                                  uint64_t seed) {
     
     std::cout << "Extracting speaker embedding..." << std::endl;
     
@@ -99,19 +176,26 @@ bool VoiceTrainer::runTrainingLoop(const Eigen::MatrixXf& melFeatures,
     
     std::cout << "Training for 60 epochs..." << std::endl;
     
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::normal_distribution<float> dist(0.0f, 0.01f);
+    const KernelTable& kernels = CpuDispatch::kernels();
+    NoiseGenerator noiseGenerator(seed);
+    std::vector<float> noise(speakerEmbedding.size());
+    
+    // Column means do not change between epochs.
+    std::vector<float> targets(speakerEmbedding.size());
+    for (int i = 0; i < speakerEmbedding.size(); ++i) {
+        int colIdx = std::min(i, (int)melFeatures.cols() - 1);
+        targets[i] = kernels.sum(melFeatures.col(colIdx).data(), melFeatures.rows()) / melFeatures.rows();
+    }
     
     for (int epoch = 0; epoch < 60; ++epoch) {
         float loss = 0.0f;
         
+        noiseGenerator.fillGaussian(noise.data(), noise.size(), 0.01f);
+        
         for (int i = 0; i < speakerEmbedding.size(); ++i) {
-            float noise = dist(gen);
-            speakerEmbedding[i] += noise * 0.001f * (60 - epoch) / 60.0f;
+            speakerEmbedding[i] += noise[i] * 0.001f * (60 - epoch) / 60.0f;
             
-            float target = melFeatures.col(std::min(i, (int)melFeatures.cols() - 1)).mean();
-            float diff = speakerEmbedding[i] - target;
+            float diff = speakerEmbedding[i] - targets[i];
             loss += diff * diff;
         }
         
@@ -131,10 +215,32 @@ bool VoiceTrainer::runTrainingLoop(const Eigen::MatrixXf& melFeatures,
     }
     
     uint32_t size = speakerEmbedding.size();
-    file.write(reinterpret_cast<char*>(&size), sizeof(uint32_t));
     
-    for (float val : speakerEmbedding) {
-        file.write(reinterpret_cast<char*>(&val), sizeof(float));
+    if (precision == Precision::Float32) {
+        file.write(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+        file.write(reinterpret_cast<char*>(speakerEmbedding.data()), size * sizeof(float));
+    } else {
+        uint32_t magic = VOICE_MODEL_MAGIC;
+        uint32_t format = uint32_t(precision);
+        file.write(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+        file.write(reinterpret_cast<char*>(&format), sizeof(uint32_t));
+        file.write(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+        
+        std::vector<float> restored(size);
+        if (precision == Precision::Float16) {
+            std::vector<uint16_t> half(size);
+            Quantizer::toHalf(speakerEmbedding.data(), half.data(), size);
+            file.write(reinterpret_cast<char*>(half.data()), size * sizeof(uint16_t));
+            Quantizer::fromHalf(half.data(), restored.data(), size);
+        } else {
+            std::vector<int8_t> quantized(size);
+            float scale = Quantizer::toInt8(speakerEmbedding.data(), quantized.data(), size);
+            file.write(reinterpret_cast<char*>(&scale), sizeof(float));
+            file.write(reinterpret_cast<char*>(quantized.data()), size);
+            Quantizer::fromInt8(quantized.data(), scale, restored.data(), size);
+        }
+        
+        Quantizer::reportError("voice embedding", precision, speakerEmbedding.data(), restored.data(), size);
     }
     
     std::cout << "Voice model saved to: " << outputPath << std::endl;
@@ -145,26 +251,20 @@ std::vector<float> VoiceTrainer::extractSpeakerEmbedding(const Eigen::MatrixXf&
     const int embeddingSize = 256;
     std::vector<float> embedding(embeddingSize);
     
+    const KernelTable& kernels = CpuDispatch::kernels();
     int stepSize = std::max(1, (int)melFeatures.cols() / embeddingSize);
     
     for (int i = 0; i < embeddingSize; ++i) {
         int colIdx = std::min(i * stepSize, (int)melFeatures.cols() - 1);
         
-        float sum = 0.0f;
-        for (int row = 0; row < melFeatures.rows(); ++row) {
-            sum += melFeatures(row, colIdx);
-        }
+        float sum = kernels.sum(melFeatures.col(colIdx).data(), melFeatures.rows());
         
         embedding[i] = sum / melFeatures.rows();
         
         embedding[i] = std::tanh(embedding[i]);
     }
     
-    float norm = 0.0f;
-    for (float val : embedding) {
-        norm += val * val;
-    }
-    norm = std::sqrt(norm);
+    float norm = std::sqrt(kernels.dot(embedding.data(), embedding.data(), embedding.size()));
     
     if (norm > 0.0f) {
         for (float& val : embedding) {
@@ -2,18 +2,29 @@
 #include <string>
 #include <vector>
 #include <Eigen/Dense>
+#include "quantizer.h"
+#include "noise_generator.h"
 
 class VoiceTrainer {
 public:
     static bool trainEncoder(const std::string& melFeaturesPath, 
                            const std::string& f0FeaturesPath,
-                           const std::string& outputModelPath);
+                           const std::string& outputModelPath,
+                           Precision precision = Precision::Float32,
+                           uint64_t seed = NoiseGenerator::randomSeed());
+    static bool trainFromFeatures(const Eigen::MatrixXf& melFeatures, 
+                                 const std::vector<float>& f0Features,
+                                 const std::string& outputModelPath,
+                                 Precision precision = Precision::Float32,
+                                 uint64_t seed = NoiseGenerator::randomSeed());
     
 private:
     static Eigen::MatrixXf loadNpyMatrix(const std::string& path);
     static std::vector<float> loadNpyVector(const std::string& path);
     static bool runTrainingLoop(const Eigen::MatrixXf& melFeatures, 
                                const std::vector<float>& f0Features,
-                               const std::string& outputPath);
+                               const std::string& outputPath,
+                               Precision precision,
+                               uint64_t seed);
     static std::vector<float> extractSpeakerEmbedding(const Eigen::MatrixXf& melFeatures);
 };
\ No newline at end of file